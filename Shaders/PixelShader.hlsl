@@ -33,6 +33,8 @@ cbuffer MeshData : register(B1)
 {
     float4x4 worldMat;
     ATTRIBUTES material;
+    float4 quantOffset;
+    float4 quantScale;
 };
 
 float4 main(outputToRasterizer outputVS) : SV_TARGET
@@ -2,9 +2,9 @@
 
 struct inputFromAssembler
 {
-    float3 pos : POS;
+    float4 pos : POS; // float3 (w = 1) or R16G16B16A16_UNORM when packed
     float3 uvm : UVM;
-    float3 nrm : NRM;
+    float3 nrm : NRM; // float3 or octahedral R16G16_SNORM (z = 0) when packed
 };
 
 struct outputToRasterizer
@@ -42,17 +42,35 @@ cbuffer MeshData : register(B1)
 {
     float4x4 worldMat;
     ATTRIBUTES material;
+    float4 quantOffset; // xyz: model bounds min, w: 1 when vertices are packed
+    float4 quantScale; // xyz: model bounds extent
 };
 
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    if (n.z < 0.0f)
+        n.xy = (1.0f - abs(n.yx)) * (n.xy >= 0.0f ? 1.0f : -1.0f);
+    return normalize(n);
+}
+
 outputToRasterizer main(inputFromAssembler inputVertex)
 {
-    float4 pos = { inputVertex.pos, 1.0f };
+    float3 position = inputVertex.pos.xyz;
+    float3 norm = inputVertex.nrm;
+    if (quantOffset.w > 0.0f) // dequantize packed vertices
+    {
+        position = quantOffset.xyz + position * quantScale.xyz;
+        norm = OctDecode(norm.xy);
+    }
+    
+    float4 pos = { position, 1.0f };
     pos = mul(pos, worldMat);
     float4 posW = pos;
     pos = mul(pos, viewMat);
     pos = mul(pos, projMat);
     
-    float4 normal = mul(float4(inputVertex.nrm, 0), worldMat);
+    float4 normal = mul(float4(norm, 0), worldMat);
     
     outputToRasterizer output;
     output.posH = pos;
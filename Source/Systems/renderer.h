@@ -8,6 +8,8 @@
 #include <d3d11.h>
 #include <iostream>
 #include "../Utils/load_data_oriented.h"
+#include "../Utils/FileWatcher.h"
+#include "../Utils/VirtualFile.h"
 #include "../Utils/h2bParser.h"
 #include "../Utils/Sprite.h"
 #include "../Utils/Font.h"
@@ -26,6 +28,8 @@ __declspec(align(16)) struct MeshData
 {
 	GW::MATH::GMATRIXF worldMat;
 	H2B::ATTRIBUTES material;
+	GW::MATH::GVECTORF quantOffset; // xyz: bounds min, w: 1 when vertices are packed
+	GW::MATH::GVECTORF quantScale; // xyz: bounds extent
 };
 __declspec(align(16)) struct SpriteData
 {
@@ -80,11 +84,29 @@ bool orthoMode = false;
 bool startOrthoCounter = false;
 int orthoCounter = 30;
 
+// Meshlet culling (frustum + backface cone), needs Level_Data::levelMeshlets
+bool meshletCulling = true;
+// Whole object frustum culling, needs Level_Data::levelInstanceBounds
+bool objectCulling = true;
+
+// Level of detail, needs Level_Data::levelMeshLods
+bool useLods = true;
+float lodPixelError = 1.0f; // coarsest level whose error stays under this many pixels is drawn
+float lodHysteresis = 1.5f; // a level is only left for a finer one once its error grows past this factor
+
+// Hot reload, watches Assets, Levels, XML & Textures and patches changed files into the running game
+bool hotReload = true;
+
+// Asset pack, when present every .h2b, level, shader, texture & xml is read from it instead of loose files
+const char* assetPack = "../Assets.pak";
+
 // Level File Paths and Array
 const char* level_00 = "../Levels/GameLevel.txt";
 const char* level_01 = "../Levels/GameLevelTest.txt";
 const char* levels[2] = { level_00, level_01 };
 int levelIndex = 0;
+// Background level loading
+enum LEVEL_LOAD_STATE { LOAD_IDLE = 0, LOAD_RUNNING, LOAD_READY, LOAD_UNLOADING };
 
 // Shader File Paths
 std::string	vs_SourcePath = "../Shaders/VertexShader.hlsl";
@@ -142,6 +164,7 @@ class Renderer
 	Microsoft::WRL::ComPtr<ID3D11VertexShader>			vertexShader;
 	Microsoft::WRL::ComPtr<ID3D11PixelShader>			pixelShader;
 	Microsoft::WRL::ComPtr<ID3D11InputLayout>			vertexFormat;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout>			vertexFormatPacked; // VertexPacking::PACKED_VERTEX
 	Microsoft::WRL::ComPtr<ID3D11Buffer>				indexBuffer;
 	// DirectX resources used for rendering 2D
 	Microsoft::WRL::ComPtr<ID3D11Buffer>				vertexBuffer_2D;
@@ -192,7 +215,19 @@ class Renderer
 	HRESULT												hr_wireframe;
 	// Level Loading Containers
 	GW::SYSTEM::GLog									log;
-	Level_Data											loadedLevel;
+	ModelCache											modelCache; // processed models kept across level switches
+	Level_Data											loadedLevel; // what is being drawn
+	Level_Data											pendingLevel; // filled in the background, then swapped in
+	std::thread											levelLoader; // dedicated so it never starves the gateware pool
+	std::atomic<int>									levelLoadState; // LEVEL_LOAD_STATE
+	std::atomic<float>									levelLoadProgress;
+	bool												levelLoadSucceeded;
+	int													reportedLoadPercent;
+	std::vector<unsigned char>							objectLods; // current level of detail per blender object
+	// Hot Reload
+	FileWatcher											assetWatcher;
+	size_t												levelVertexCapacity; // bytes the level buffers were created with
+	size_t												levelIndexCapacity;
 	// Music and SoundFX data
 	GW::AUDIO::GAudio									audioPlayer;
 	GW::AUDIO::GSound									loadingFX;
@@ -208,8 +243,30 @@ public:
 		win = _win;
 		d3d = _d3d;
 
+		// one log for the lifetime of the renderer, shared with the background loader
+		log.Create("../LevelLoaderLog.txt");
+		log.EnableConsoleLogging(true); // mirror output to the console
+		log.Log("Start Program.");
+		// before anything is read, loose files are only used for what the pack doesn't have
+		if (VirtualFile::Mount(assetPack) == true)
+			log.LogCategorized("INFO", (std::string("Reading assets from ") + assetPack).c_str());
+		levelLoadState = LEVEL_LOAD_STATE::LOAD_IDLE;
+		loadedLevel.settings.modelCache = &modelCache; // both levels swap, so both share it
+		pendingLevel.settings.modelCache = &modelCache;
+		levelLoadProgress = 0.0f;
+		levelVertexCapacity = 0;
+		levelIndexCapacity = 0;
+
 		loadLevel();
 		InitializeAll();
+		BlockCompression::STATS inflated = VirtualFile::InflateStats();
+		if (inflated.rawBytes > 0) // textures, shaders & models inflated out of the pack so far
+			log.LogCategorized("INFO", ("Pack files inflated " + std::to_string(inflated.rawBytes / 1024) + " KB from " +
+				std::to_string(inflated.packedBytes / 1024) + " KB in " + std::to_string(inflated.seconds * 1000.0) + " ms, " +
+				std::to_string(static_cast<unsigned>(inflated.MBps())) + " MB/s, " +
+				std::to_string(static_cast<unsigned>(inflated.MBpsPerCore())) + " MB/s per core").c_str());
+		if (hotReload == true && VirtualFile::IsMounted() == false) // packed builds don't change under us
+			WatchAssetFolders();
 
 		inputProxy.Create(win);
 		controllerInputProxy.Create();
@@ -219,6 +276,9 @@ public:
 	~Renderer()
 	{
 		// Not much needed here - as most d3d11 objects get released after use rather than inside deconstructor
+		// but a level may still be loading in the background
+		if (levelLoader.joinable())
+			levelLoader.join();
 	}
 
 	// Called Each Frame - Renders 3D Scene
@@ -237,7 +297,6 @@ public:
 			win.GetClientWidth(screenWidth);
 
 			D3D11_MAPPED_SUBRESOURCE sub1 = { 0 };
-			D3D11_MAPPED_SUBRESOURCE sub2 = { 0 };
 
 			// Wireframe Mode
 			if (wireFrameMode == true)
@@ -278,31 +337,8 @@ public:
 
 				curHandles.context->RSSetViewports(1u, &vp);
 
-				// loop through all objects in current loaded level and extract needed data
-				// loop through all objects in current loaded level and extract needed data
-				for (const auto& b : loadedLevel.blenderObjects)
-				{
-					const int& modelIndex = b.modelIndex;
-					const int& transformIndex = b.transformIndex;
-
-					for (unsigned int j = 0; j < loadedLevel.levelModels[modelIndex].meshCount; j++)
-					{
-						const unsigned int& meshIndex = j + loadedLevel.levelModels[modelIndex].meshStart;
-						const H2B::MESH* mesh = &loadedLevel.levelMeshes[meshIndex];
-						const unsigned int& matIndex = j + loadedLevel.levelModels[modelIndex].materialStart;
-						cbuffMeshData.material = loadedLevel.levelMaterials[matIndex].attrib;
-						cbuffMeshData.worldMat = loadedLevel.levelTransforms[transformIndex];
-
-						curHandles.context->Map(cbuffMesh.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &sub2);
-						memcpy(sub2.pData, &cbuffMeshData, sizeof(cbuffMeshData));
-						curHandles.context->Unmap(cbuffMesh.Get(), 0);
-
-						curHandles.context->DrawIndexed(mesh->drawInfo.indexCount,
-							mesh->drawInfo.indexOffset + loadedLevel.levelModels[modelIndex].indexStart, loadedLevel.levelModels[modelIndex].vertexStart);
-
-						mesh = nullptr;
-					}
-				}
+				// draw every object in the current loaded level
+				DrawLevel(curHandles);
 			}
 			else if (splitScreen == true)
 			{
@@ -317,30 +353,8 @@ public:
 
 				curHandles.context->RSSetViewports(1u, &left_vp);
 
-				// loop through all objects in current loaded level and extract needed data
-				for (const auto& b : loadedLevel.blenderObjects)
-				{
-					const int& modelIndex = b.modelIndex;
-					const int& transformIndex = b.transformIndex;
-
-					for (unsigned int j = 0; j < loadedLevel.levelModels[modelIndex].meshCount; j++)
-					{
-						const unsigned int& meshIndex = j + loadedLevel.levelModels[modelIndex].meshStart;
-						const H2B::MESH* mesh = &loadedLevel.levelMeshes[meshIndex];
-						const unsigned int& matIndex = j + loadedLevel.levelModels[modelIndex].materialStart;
-						cbuffMeshData.material = loadedLevel.levelMaterials[matIndex].attrib;
-						cbuffMeshData.worldMat = loadedLevel.levelTransforms[transformIndex];
-
-						curHandles.context->Map(cbuffMesh.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &sub2);
-						memcpy(sub2.pData, &cbuffMeshData, sizeof(cbuffMeshData));
-						curHandles.context->Unmap(cbuffMesh.Get(), 0);
-
-						curHandles.context->DrawIndexed(mesh->drawInfo.indexCount,
-							mesh->drawInfo.indexOffset + loadedLevel.levelModels[modelIndex].indexStart, loadedLevel.levelModels[modelIndex].vertexStart);
-
-						mesh = nullptr;
-					}
-				}
+				// draw every object in the current loaded level
+				DrawLevel(curHandles);
 
 				// right viewport
 				D3D11_VIEWPORT right_vp{};
@@ -353,30 +367,8 @@ public:
 
 				curHandles.context->RSSetViewports(1u, &right_vp);
 
-				// loop through all objects in current loaded level and extract needed data
-				for (const auto& b : loadedLevel.blenderObjects)
-				{
-					const int& modelIndex = b.modelIndex;
-					const int& transformIndex = b.transformIndex;
-
-					for (unsigned int j = 0; j < loadedLevel.levelModels[modelIndex].meshCount; j++)
-					{
-						const unsigned int& meshIndex = j + loadedLevel.levelModels[modelIndex].meshStart;
-						const H2B::MESH* mesh = &loadedLevel.levelMeshes[meshIndex];
-						const unsigned int& matIndex = j + loadedLevel.levelModels[modelIndex].materialStart;
-						cbuffMeshData.material = loadedLevel.levelMaterials[matIndex].attrib;
-						cbuffMeshData.worldMat = loadedLevel.levelTransforms[transformIndex];
-
-						curHandles.context->Map(cbuffMesh.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &sub2);
-						memcpy(sub2.pData, &cbuffMeshData, sizeof(cbuffMeshData));
-						curHandles.context->Unmap(cbuffMesh.Get(), 0);
-
-						curHandles.context->DrawIndexed(mesh->drawInfo.indexCount,
-							mesh->drawInfo.indexOffset + loadedLevel.levelModels[modelIndex].indexStart, loadedLevel.levelModels[modelIndex].vertexStart);
-
-						mesh = nullptr;
-					}
-				}
+				// draw every object in the current loaded level
+				DrawLevel(curHandles);
 			}
 
 			ReleasePipelineHandles(curHandles);
@@ -516,6 +508,11 @@ public:
 	// Called Each Frame - Updates Scene
 	void Update()
 	{
+		// swap in a level finished by the background loader (frame boundary)
+		FinishLevelLoad();
+		// patch in whatever changed on disk since the last frame
+		PollHotReload();
+
 		// background music
 		bool isMusicPlaying;
 		music.isPlaying(isMusicPlaying);
@@ -546,7 +543,7 @@ public:
 		{
 			totalDoChangeLevel = true;
 		}
-		if (totalDoChangeLevel == true)
+		if (totalDoChangeLevel == true && levelLoadState == LEVEL_LOAD_STATE::LOAD_IDLE)
 		{
 			totalDoChangeLevel = false;
 			levelIndex += 1;
@@ -556,7 +553,7 @@ public:
 				levelIndex = 0;
 			}
 
-			loadLevel();
+			BeginLevelLoad();
 		}
 
 		// Camera Code
@@ -932,12 +929,12 @@ private:
 	}
 	void InitializeIndexBuffer(ID3D11Device* creator)
 	{
-		CreateIndexBuffer(creator, loadedLevel.levelIndices.data(), sizeof(unsigned int) * loadedLevel.levelIndices.size());
+		CreateLevelIndexBuffer(creator);
 		CreateIndexBuffer2D(creator);
 	}
 	void InitializeVertexBuffer(ID3D11Device* creator)
 	{
-		CreateVertexBuffer(creator, loadedLevel.levelVertices.data(), sizeof(H2B::VERTEX) * loadedLevel.levelVertices.size());
+		CreateLevelVertexBuffer(creator);
 		CreateVertexBuffer2D(creator);
 	}
 	void InitializeMatricesAndVariables()
@@ -1066,10 +1063,15 @@ private:
 	}
 	void CreateIndexBuffer(ID3D11Device* creator, const void* data, unsigned int sizeInBytes)
 	{
-		D3D11_SUBRESOURCE_DATA bData = { data, 0, 0 };
-		CD3D11_BUFFER_DESC bDesc(sizeInBytes, D3D11_BIND_INDEX_BUFFER);
-
-		creator->CreateBuffer(&bDesc, &bData, &indexBuffer);
+		CreateLevelBuffer(creator, data, sizeInBytes, D3D11_BIND_INDEX_BUFFER, indexBuffer, levelIndexCapacity);
+	}
+	void CreateLevelIndexBuffer(ID3D11Device* creator)
+	{
+		// mixed 16/32 bit ranges, DrawLevel binds the right format per model
+		if (loadedLevel.levelIndexBuffer.empty() == false)
+			CreateIndexBuffer(creator, loadedLevel.levelIndexBuffer.data(), loadedLevel.levelIndexBuffer.size());
+		else
+			CreateIndexBuffer(creator, loadedLevel.levelIndices.data(), sizeof(unsigned int) * loadedLevel.levelIndices.size());
 	}
 	void CreateIndexBuffer2D(ID3D11Device* creator)
 	{
@@ -1079,9 +1081,35 @@ private:
 	}
 	void CreateVertexBuffer(ID3D11Device* creator, const void* data, unsigned int sizeInBytes)
 	{
-		D3D11_SUBRESOURCE_DATA bData = { data, 0, 0 };
-		CD3D11_BUFFER_DESC bDesc(sizeInBytes, D3D11_BIND_VERTEX_BUFFER);
-		creator->CreateBuffer(&bDesc, &bData, vertexBuffer.GetAddressOf());
+		CreateLevelBuffer(creator, data, sizeInBytes, D3D11_BIND_VERTEX_BUFFER, vertexBuffer, levelVertexCapacity);
+	}
+	// level geometry, with spare room when hot reload may append models that outgrew their range
+	void CreateLevelBuffer(ID3D11Device* creator, const void* data, size_t sizeInBytes, UINT bindFlags,
+		Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, size_t& capacity)
+	{
+		capacity = (hotReload == true) ? (sizeInBytes + sizeInBytes / 4 + 15) & ~size_t(15) : sizeInBytes;
+		CD3D11_BUFFER_DESC bDesc(static_cast<UINT>(capacity), bindFlags);
+		creator->CreateBuffer(&bDesc, nullptr, buffer.ReleaseAndGetAddressOf());
+		UploadBufferRange(buffer.Get(), data, 0, sizeInBytes);
+	}
+	// copies bytes [start, start + count) of "data" to the same place in "buffer"
+	void UploadBufferRange(ID3D11Buffer* buffer, const void* data, size_t start, size_t count)
+	{
+		if (buffer == nullptr || count == 0)
+			return;
+		ID3D11DeviceContext* context;
+		d3d.GetImmediateContext((void**)&context);
+		D3D11_BOX box = { static_cast<UINT>(start), 0, 0, static_cast<UINT>(start + count), 1, 1 };
+		context->UpdateSubresource(buffer, 0, &box, static_cast<const char*>(data) + start, 0, 0);
+		context->Release();
+	}
+	void CreateLevelVertexBuffer(ID3D11Device* creator)
+	{
+		// only one of the two formats goes to the GPU
+		if (loadedLevel.levelPackedVertices.empty() == false)
+			CreateVertexBuffer(creator, loadedLevel.levelPackedVertices.data(), sizeof(VertexPacking::PACKED_VERTEX) * loadedLevel.levelPackedVertices.size());
+		else
+			CreateVertexBuffer(creator, loadedLevel.levelVertices.data(), sizeof(H2B::VERTEX) * loadedLevel.levelVertices.size());
 	}
 	void CreateVertexBuffer2D(ID3D11Device* creator)
 	{
@@ -1188,6 +1216,7 @@ private:
 		Microsoft::WRL::ComPtr<ID3DBlob> psBlob = CompilePixelShader(creator, compilerFlags);
 
 		CreateVertexInputLayout(creator, vsBlob);
+		CreatePackedVertexInputLayout(creator, vsBlob);
 
 		Microsoft::WRL::ComPtr<ID3DBlob> vsBlob_2D = CompileVertexShader_2D(creator, compilerFlags);
 		Microsoft::WRL::ComPtr<ID3DBlob> psBlob_2D = CompilePixelShader_2D(creator, compilerFlags);
@@ -1337,6 +1366,20 @@ private:
 			vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(),
 			vertexFormat.GetAddressOf());
 	}
+	void CreatePackedVertexInputLayout(ID3D11Device* creator, Microsoft::WRL::ComPtr<ID3DBlob>& vsBlob)
+	{
+		// same semantics as the float layout, VertexShader.hlsl dequantizes
+		D3D11_INPUT_ELEMENT_DESC format[] =
+		{
+			{ "POS", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "UVM", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "NRM", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+		};
+
+		creator->CreateInputLayout(format, ARRAYSIZE(format),
+			vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(),
+			vertexFormatPacked.GetAddressOf());
+	}
 	void CreateVertexInputLayout_2D(ID3D11Device* creator, Microsoft::WRL::ComPtr<ID3DBlob>& vsBlob)
 	{
 		D3D11_INPUT_ELEMENT_DESC format[] =
@@ -1393,7 +1436,8 @@ private:
 		SetVertexBuffers(handles);
 		SetShaders(handles);
 
-		handles.context->IASetInputLayout(vertexFormat.Get());
+		const bool packed = loadedLevel.levelPackedVertices.empty() == false;
+		handles.context->IASetInputLayout(packed ? vertexFormatPacked.Get() : vertexFormat.Get());
 		handles.context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 		handles.context->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
@@ -1410,7 +1454,8 @@ private:
 	}
 	void SetVertexBuffers(PipelineHandles handles)
 	{
-		const UINT strides[] = { sizeof(OBJ_VERT) };
+		const bool packed = loadedLevel.levelPackedVertices.empty() == false;
+		const UINT strides[] = { packed ? sizeof(VertexPacking::PACKED_VERTEX) : sizeof(OBJ_VERT) };
 		const UINT offsets[] = { 0 };
 		ID3D11Buffer* const buffs[] = { vertexBuffer.Get() };
 		handles.context->IASetVertexBuffers(0, ARRAYSIZE(buffs), buffs, strides, offsets);
@@ -1420,6 +1465,216 @@ private:
 		handles.context->VSSetShader(vertexShader.Get(), nullptr, 0);
 		handles.context->PSSetShader(pixelShader.Get(), nullptr, 0);
 	}
+	// world space frustum planes (xyz: normal pointing inside, w: distance) of a row vector view * projection
+	void ExtractFrustumPlanes(const GW::MATH::GMATRIXF& viewProj, GW::MATH::GVECTORF planes[6])
+	{
+		const float* m = viewProj.data;
+		for (int i = 0; i < 3; ++i)
+		{
+			// clip = p * viewProj, so each clip coordinate is a column of the matrix
+			const float col4[4] = { m[3], m[7], m[11], m[15] };
+			const float col[4] = { m[i], m[i + 4], m[i + 8], m[i + 12] };
+			if (i < 2)
+			{
+				planes[i * 2] = { col4[0] + col[0], col4[1] + col[1], col4[2] + col[2], col4[3] + col[3] };
+				planes[i * 2 + 1] = { col4[0] - col[0], col4[1] - col[1], col4[2] - col[2], col4[3] - col[3] };
+			}
+			else // D3D depth runs 0 to w
+			{
+				planes[4] = { col[0], col[1], col[2], col[3] };
+				planes[5] = { col4[0] - col[0], col4[1] - col[1], col4[2] - col[2], col4[3] - col[3] };
+			}
+		}
+		for (int i = 0; i < 6; ++i)
+		{
+			float len = std::sqrt(planes[i].x * planes[i].x + planes[i].y * planes[i].y + planes[i].z * planes[i].z);
+			planes[i] = { planes[i].x / len, planes[i].y / len, planes[i].z / len, planes[i].w / len };
+		}
+	}
+	bool SphereInFrustum(const GW::MATH::GVECTORF planes[6], float x, float y, float z, float radius)
+	{
+		for (int i = 0; i < 6; ++i)
+			if (planes[i].x * x + planes[i].y * y + planes[i].z * z + planes[i].w < -radius)
+				return false;
+		return true;
+	}
+	// draws the visible meshlets of one mesh, merging neighbors into as few calls as possible
+	void DrawMeshlets(PipelineHandles handles, unsigned int meshIndex, const GW::MATH::GMATRIXF& world,
+		float worldScale, bool useCones, const GW::MATH::GVECTORF& modelEye, const GW::MATH::GVECTORF planes[6],
+		unsigned int firstIndex, unsigned int baseVertex)
+	{
+		const Level_Data::MESHLET_RANGE& range = loadedLevel.levelMeshletRanges[meshIndex];
+		unsigned int runStart = 0, runCount = 0;
+		for (unsigned int k = 0; k < range.meshletCount; k++)
+		{
+			const MeshOptimizer::MESHLET& m = loadedLevel.levelMeshlets[range.meshletStart + k];
+			const float cx = m.center.x * world.row1.x + m.center.y * world.row2.x + m.center.z * world.row3.x + world.row4.x;
+			const float cy = m.center.x * world.row1.y + m.center.y * world.row2.y + m.center.z * world.row3.y + world.row4.y;
+			const float cz = m.center.x * world.row1.z + m.center.y * world.row2.z + m.center.z * world.row3.z + world.row4.z;
+			bool visible = SphereInFrustum(planes, cx, cy, cz, m.radius * worldScale);
+			if (visible == true && useCones == true)
+				visible = MeshOptimizer::ConeBackfacing(m, modelEye.x, modelEye.y, modelEye.z) == false;
+			if (visible == true)
+			{
+				if (runCount == 0)
+					runStart = m.indexOffset;
+				runCount += m.triangleCount * 3;
+				continue;
+			}
+			if (runCount > 0)
+				handles.context->DrawIndexed(runCount, runStart + firstIndex, baseVertex);
+			runCount = 0;
+		}
+		if (runCount > 0)
+			handles.context->DrawIndexed(runCount, runStart + firstIndex, baseVertex);
+	}
+	// projected screen space error picks the level, moving one way only past the hysteresis band
+	unsigned int SelectLod(size_t objectIndex, const Level_Data::LEVEL_MODEL& model,
+		unsigned int transformIndex, float worldScale, float pixelScale)
+	{
+		unsigned int lodCount = 0xFF;
+		for (unsigned int j = 0; j < model.meshCount; j++)
+			lodCount = (std::min)(lodCount, loadedLevel.levelMeshLodRanges[model.meshStart + j].lodCount);
+		auto lodError = [&](unsigned int level) {
+			float error = 0.0f;
+			for (unsigned int j = 0; j < model.meshCount; j++)
+			{
+				const Level_Data::LOD_RANGE& range = loadedLevel.levelMeshLodRanges[model.meshStart + j];
+				error = (std::max)(error, loadedLevel.levelMeshLods[range.lodStart + level].error);
+			}
+			return error * worldScale;
+		};
+		// distance from the camera to the instance's world space bounding sphere
+		const float* sphere = loadedLevel.levelInstanceBounds[transformIndex].sphere;
+		const float dx = sphere[0] - cbuffSceneData.camWorldPos.x;
+		const float dy = sphere[1] - cbuffSceneData.camWorldPos.y;
+		const float dz = sphere[2] - cbuffSceneData.camWorldPos.z;
+		const float distance = (std::max)(std::sqrt(dx * dx + dy * dy + dz * dz) - sphere[3], 0.1f);
+		// orthographic projections don't shrink with distance
+		const float pixelsPerUnit = (orthoMode == true) ? pixelScale : pixelScale / distance;
+
+		unsigned int current = (std::min)(static_cast<unsigned int>(objectLods[objectIndex]), lodCount - 1);
+		while (current + 1 < lodCount && lodError(current + 1) * pixelsPerUnit < lodPixelError)
+			current++;
+		while (current > 0 && lodError(current) * pixelsPerUnit > lodPixelError * lodHysteresis)
+			current--;
+		objectLods[objectIndex] = static_cast<unsigned char>(current);
+		return current;
+	}
+	void DrawLevel(PipelineHandles handles)
+	{
+		D3D11_MAPPED_SUBRESOURCE sub = { 0 };
+		const bool packed = loadedLevel.levelPackedVertices.empty() == false;
+		const bool narrowed = loadedLevel.levelIndexBuffer.empty() == false;
+		const bool cullMeshlets = meshletCulling == true && loadedLevel.levelMeshlets.empty() == false;
+		const bool cullObjects = objectCulling == true &&
+			loadedLevel.levelInstanceBounds.size() == loadedLevel.levelTransforms.size();
+		int boundModel = -1;
+
+		// everything the meshlet tests need that doesn't change per object
+		GW::MATH::GVECTORF planes[6];
+		GW::MATH::GMATRIXF viewProj;
+		GW::MATH::GMatrix::MultiplyMatrixF(cbuffSceneData.viewMat, cbuffSceneData.projMat, viewProj);
+		ExtractFrustumPlanes(viewProj, planes);
+		// wireframe draws back faces and ortho has no single eye point
+		const bool conesAllowed = wireFrameMode == false && orthoMode == false;
+
+		// pixels one world unit covers at distance 1 (or anywhere in ortho mode)
+		const bool pickLods = useLods == true && loadedLevel.levelMeshLods.empty() == false &&
+			loadedLevel.levelInstanceBounds.size() == loadedLevel.levelTransforms.size();
+		if (objectLods.size() != loadedLevel.blenderObjects.size())
+			objectLods.assign(loadedLevel.blenderObjects.size(), 0);
+		UINT screenHeight = 0;
+		win.GetClientHeight(screenHeight);
+		const float pixelScale = 0.5f * screenHeight * cbuffSceneData.projMat.row2.y;
+
+		// loop through all objects in current loaded level and extract needed data
+		for (size_t objectIndex = 0; objectIndex < loadedLevel.blenderObjects.size(); objectIndex++)
+		{
+			const Level_Data::BLENDER_OBJECT& b = loadedLevel.blenderObjects[objectIndex];
+			const int& modelIndex = b.modelIndex;
+			const int& transformIndex = b.transformIndex;
+			const Level_Data::LEVEL_MODEL& model = loadedLevel.levelModels[modelIndex];
+			// world space sphere precomputed at load, skips every mesh of an object off screen
+			if (cullObjects == true)
+			{
+				const float* sphere = loadedLevel.levelInstanceBounds[transformIndex].sphere;
+				if (SphereInFrustum(planes, sphere[0], sphere[1], sphere[2], sphere[3]) == false)
+					continue;
+			}
+			// cones are tested in model space, which only keeps their angles under uniform, unmirrored scale
+			const GW::MATH::GMATRIXF& world = loadedLevel.levelTransforms[transformIndex];
+			const float sx = std::sqrt(world.row1.x * world.row1.x + world.row1.y * world.row1.y + world.row1.z * world.row1.z);
+			const float sy = std::sqrt(world.row2.x * world.row2.x + world.row2.y * world.row2.y + world.row2.z * world.row2.z);
+			const float sz = std::sqrt(world.row3.x * world.row3.x + world.row3.y * world.row3.y + world.row3.z * world.row3.z);
+			const float worldScale = (std::max)(sx, (std::max)(sy, sz));
+			const unsigned int lod = (pickLods == true) ? SelectLod(objectIndex, model, transformIndex, worldScale, pixelScale) : 0;
+			bool useCones = false;
+			GW::MATH::GVECTORF modelEye = cbuffSceneData.camWorldPos;
+			if (cullMeshlets == true && lod == 0)
+			{
+				const float smallest = (std::min)(sx, (std::min)(sy, sz));
+				float determinant = 0.0f;
+				GW::MATH::GMatrix::DeterminantF(world, determinant);
+				GW::MATH::GMATRIXF inverseWorld;
+				useCones = conesAllowed == true && determinant > 0.0f && worldScale - smallest <= worldScale * 0.01f &&
+					+GW::MATH::GMatrix::InverseF(world, inverseWorld);
+				if (useCones == true)
+				{
+					GW::MATH::GVECTORF eye = { modelEye.x, modelEye.y, modelEye.z, 1.0f };
+					GW::MATH::GMatrix::VectorXMatrixF(inverseWorld, eye, modelEye);
+				}
+			}
+
+			for (unsigned int j = 0; j < model.meshCount; j++)
+			{
+				const unsigned int& meshIndex = j + model.meshStart;
+				const H2B::MESH* mesh = &loadedLevel.levelMeshes[meshIndex];
+				// a mesh shared with another model draws from that model's ranges
+				const int geometryIndex = loadedLevel.levelMeshGeometry.empty() ? modelIndex :
+					static_cast<int>(loadedLevel.levelMeshGeometry[meshIndex]);
+				const Level_Data::LEVEL_MODEL& geometry = loadedLevel.levelModels[geometryIndex];
+				// objects come grouped by model, so this only rebinds when the model changes
+				unsigned int firstIndex = geometry.indexStart;
+				if (narrowed == true)
+				{
+					if (boundModel != geometryIndex)
+					{
+						handles.context->IASetIndexBuffer(indexBuffer.Get(),
+							geometry.indexFormat == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, geometry.indexByteOffset);
+						boundModel = geometryIndex;
+					}
+					firstIndex = 0; // the binding offset already points at this model
+				}
+				// range the vertex shader dequantizes packed positions with
+				const VertexPacking::BOUNDS& bounds = geometry.vertexBounds;
+				cbuffMeshData.quantOffset = { bounds.min.x, bounds.min.y, bounds.min.z, packed ? 1.0f : 0.0f };
+				cbuffMeshData.quantScale = { bounds.extent.x, bounds.extent.y, bounds.extent.z, 0.0f };
+				const unsigned int& matIndex = loadedLevel.levelMeshMaterials[meshIndex];
+				cbuffMeshData.material = loadedLevel.levelMaterials[matIndex].attrib;
+				cbuffMeshData.worldMat = loadedLevel.levelTransforms[transformIndex];
+
+				handles.context->Map(cbuffMesh.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &sub);
+				memcpy(sub.pData, &cbuffMeshData, sizeof(cbuffMeshData));
+				handles.context->Unmap(cbuffMesh.Get(), 0);
+
+				if (lod > 0) // simplified ranges aren't split into meshlets
+				{
+					const Level_Data::LOD_RANGE& range = loadedLevel.levelMeshLodRanges[meshIndex];
+					const MeshOptimizer::MESH_LOD& level = loadedLevel.levelMeshLods[range.lodStart + lod];
+					handles.context->DrawIndexed(level.indexCount, level.indexOffset + firstIndex, geometry.vertexStart);
+				}
+				else if (cullMeshlets == true)
+					DrawMeshlets(handles, meshIndex, world, worldScale, useCones, modelEye, planes,
+						firstIndex, geometry.vertexStart);
+				else
+					handles.context->DrawIndexed(mesh->drawInfo.indexCount,
+						mesh->drawInfo.indexOffset + firstIndex, geometry.vertexStart);
+
+				mesh = nullptr;
+			}
+		}
+	}
 	void ReleasePipelineHandles(PipelineHandles toRelease)
 	{
 		toRelease.depthStencil->Release();
@@ -1434,8 +1689,11 @@ private:
 	{
 		std::vector<Sprite> result;
 
+		// loose or from the mounted asset pack
+		VirtualFile file;
 		tinyxml2::XMLDocument document;
-		tinyxml2::XMLError error_message = document.LoadFile(filepath.c_str());
+		tinyxml2::XMLError error_message = (file.Open(filepath.c_str()) == false) ? tinyxml2::XML_ERROR_FILE_NOT_FOUND :
+			document.Parse(reinterpret_cast<const char*>(file.Data()), file.Size());
 		if (error_message != tinyxml2::XML_SUCCESS)
 		{
 			std::cout << "XML file [" + filepath + "] did not load properly." << std::endl;
@@ -1522,34 +1780,34 @@ private:
 	{
 		indexBuffer.Reset();
 		vertexBuffer.Reset();
-		CreateIndexBuffer(creator, loadedLevel.levelIndices.data(), sizeof(unsigned int) * loadedLevel.levelIndices.size());
-		CreateVertexBuffer(creator, loadedLevel.levelVertices.data(), sizeof(H2B::VERTEX) * loadedLevel.levelVertices.size());
+		CreateLevelIndexBuffer(creator);
+		CreateLevelVertexBuffer(creator);
 	}
 	void loadSprites(ID3D11Device* creator)
 	{
 		for (size_t i = 0; i < ARRAYSIZE(texture_names); i++)
 		{
-			// create a wide string to store the file path and file name
-			std::wstring texturePath = LTEXTURES_PATH;
-			texturePath += texture_names[i];
-			// load texture from disk 
-			DirectX::CreateDDSTextureFromFile(creator, texturePath.c_str(), nullptr, shaderResourceView[i].GetAddressOf());
+			// load texture from the asset pack or disk
+			LoadTexture(creator, texture_names[i], shaderResourceView[i]);
 		}
 
 		CD3D11_SAMPLER_DESC samp_desc = CD3D11_SAMPLER_DESC(CD3D11_DEFAULT());
 		creator->CreateSamplerState(&samp_desc, samplerState.GetAddressOf());
 	}
+	// a .dds from Textures, through the asset pack when it has the file
+	bool LoadTexture(ID3D11Device* creator, const std::wstring& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& out)
+	{
+		VirtualFile file;
+		if (file.Open((TEXTURES_PATH + std::string(name.begin(), name.end())).c_str()) == false)
+			return false;
+		return SUCCEEDED(DirectX::CreateDDSTextureFromMemory(creator, file.Data(), file.Size(), nullptr, out.ReleaseAndGetAddressOf()));
+	}
+	// synchronous load, only used at start up before anything is drawn
 	void loadLevel()
 	{
 		const char* levelToLoad = levels[levelIndex];
 
-		// begin loading level
-		log.Create("../LevelLoaderLog.txt");
-		log.EnableConsoleLogging(true); // mirror output to the console
-		log.Log("Start Program.");
-
-		loadedLevel.UnloadLevel();
-		loadedLevel.LoadLevel(levelToLoad, "../Assets", log.Relinquish());
+		loadedLevel.LoadLevel(levelToLoad, "../Assets", log);
 
 		ID3D11Device* creator;
 		d3d.GetDevice((void**)&creator);
@@ -1558,7 +1816,171 @@ private:
 		cbuffMesh.Reset();
 		cbuffScene.Reset();
 		InitializeConstantBuffers(creator);
+		creator->Release();
+
+		PlayLoadingSound();
+	}
+	// starts filling pendingLevel on a worker thread, the current level keeps rendering
+	void BeginLevelLoad()
+	{
+		int expected = LEVEL_LOAD_STATE::LOAD_IDLE;
+		if (levelLoadState.compare_exchange_strong(expected, LEVEL_LOAD_STATE::LOAD_RUNNING) == false)
+			return; // one level switch at a time
+
+		const char* levelToLoad = levels[levelIndex];
+		levelLoadProgress = 0.0f;
+		reportedLoadPercent = -1;
+		if (levelLoader.joinable())
+			levelLoader.join(); // previous unload is already done when idle
+		levelLoader = std::thread([this, levelToLoad]()
+			{
+				levelLoadSucceeded = pendingLevel.LoadLevel(levelToLoad, "../Assets", log, &levelLoadProgress);
+				levelLoadState = LEVEL_LOAD_STATE::LOAD_READY;
+			});
 
+		PlayLoadingSound();
+	}
+	// called once per frame, swaps a finished level in and uploads its buffers
+	void FinishLevelLoad()
+	{
+		int state = levelLoadState;
+		if (state == LEVEL_LOAD_STATE::LOAD_RUNNING)
+		{
+			int percent = static_cast<int>(levelLoadProgress * 100.0f);
+			if (percent / 10 != reportedLoadPercent / 10) // report every 10%
+			{
+				reportedLoadPercent = percent;
+				log.LogCategorized("INFO", ("Loading level: " + std::to_string(percent) + "%").c_str());
+			}
+			return;
+		}
+		if (state != LEVEL_LOAD_STATE::LOAD_READY)
+			return;
+		levelLoader.join(); // already finished, just reclaims the thread
+
+		if (levelLoadSucceeded == true)
+		{
+			std::swap(loadedLevel, pendingLevel);
+			objectLods.clear(); // per object LOD state belongs to the old level
+
+			ID3D11Device* creator;
+			d3d.GetDevice((void**)&creator);
+			ReInitializeBuffers(creator);
+			creator->Release();
+		}
+		else
+		{
+			log.LogCategorized("ERROR", "Level switch failed, keeping the current level.");
+		}
+
+		// the old level is freed off the render thread too
+		levelLoadState = LEVEL_LOAD_STATE::LOAD_UNLOADING;
+		levelLoader = std::thread([this]()
+			{
+				pendingLevel.UnloadLevel();
+				levelLoadState = LEVEL_LOAD_STATE::LOAD_IDLE;
+			});
+	}
+	// Hot reload
+	void WatchAssetFolders()
+	{
+		const char* folders[] = { "../Assets", "../Levels", XML_PATH, TEXTURES_PATH };
+		for (const char* folder : folders)
+			if (assetWatcher.Watch(folder) == false)
+				log.LogCategorized("WARNING", (std::string("Hot reload can't watch ") + folder).c_str());
+	}
+	// called once per frame, reloads only the files that changed
+	void PollHotReload()
+	{
+		if (assetWatcher.IsWatching() == false || levelLoadState != LEVEL_LOAD_STATE::LOAD_IDLE)
+			return; // changes stay queued until the level switch is done
+		std::vector<FileWatcher::CHANGE> changes;
+		assetWatcher.Poll(changes);
+		Level_Data::LEVEL_PATCH patch;
+		for (const FileWatcher::CHANGE& c : changes)
+		{
+			const size_t dot = c.file.find_last_of('.');
+			const std::string extension = (dot == std::string::npos) ? "" : c.file.substr(dot);
+			if (c.directory == "../Assets" && extension == ".h2b")
+				loadedLevel.ReloadModel("../Assets", c.file.c_str(), log, patch); // false when the level doesn't use it
+			else if (c.directory == "../Levels" && "../Levels/" + c.file == levels[levelIndex]) {
+				loadedLevel.ReloadLayout(levels[levelIndex], "../Assets", log, patch);
+				objectLods.clear(); // objects may now be different ones at the same indices
+			}
+			else if (c.directory == XML_PATH && c.file == "hud.xml")
+				ReloadHud();
+			else if (c.directory == XML_PATH && c.file == "font_consolas_32.xml")
+				ReloadFont();
+			else if (c.directory == TEXTURES_PATH && extension == ".dds")
+				ReloadTexture(c.file);
+		}
+		if (patch.Empty() == false)
+			UploadLevelPatch(patch);
+	}
+	// mirrors a Level_Data patch on the GPU, only the bytes it touched unless a buffer has to grow
+	void UploadLevelPatch(const Level_Data::LEVEL_PATCH& patch)
+	{
+		const bool packed = loadedLevel.levelPackedVertices.empty() == false;
+		const bool narrowed = loadedLevel.levelIndexBuffer.empty() == false;
+		const size_t stride = packed ? sizeof(VertexPacking::PACKED_VERTEX) : sizeof(H2B::VERTEX);
+		const void* vertices = packed ? static_cast<const void*>(loadedLevel.levelPackedVertices.data()) :
+			static_cast<const void*>(loadedLevel.levelVertices.data());
+		const void* indices = narrowed ? static_cast<const void*>(loadedLevel.levelIndexBuffer.data()) :
+			static_cast<const void*>(loadedLevel.levelIndices.data());
+		const size_t vertexBytes = stride * loadedLevel.levelVertices.size();
+		const size_t indexBytes = narrowed ? loadedLevel.levelIndexBuffer.size() : sizeof(unsigned int) * loadedLevel.levelIndices.size();
+		if (vertexBytes > levelVertexCapacity || indexBytes > levelIndexCapacity)
+		{
+			ID3D11Device* creator;
+			d3d.GetDevice((void**)&creator);
+			ReInitializeBuffers(creator); // with fresh room to grow
+			creator->Release();
+			log.LogCategorized("INFO", ("Hot reload outgrew the level buffers, uploaded all " +
+				std::to_string((vertexBytes + indexBytes) / 1024) + " KB").c_str());
+			return;
+		}
+		UploadBufferRange(vertexBuffer.Get(), vertices, patch.vertexStart * stride, patch.vertexCount * stride);
+		UploadBufferRange(indexBuffer.Get(), indices, patch.indexByteStart, patch.indexByteCount);
+		log.LogCategorized("INFO", ("Hot reload uploaded " +
+			std::to_string((patch.vertexCount * stride + patch.indexByteCount) / 1024) + " KB").c_str());
+	}
+	void ReloadHud()
+	{
+		hud.clear();
+		loadHUD();
+		log.LogCategorized("EVENT", "Hot reloaded hud.xml");
+	}
+	void ReloadFont()
+	{
+		consolas32 = Font(); // LoadFromXML appends to what is there
+		vertexBufferStaticText.Reset();
+		vertexBufferDynamicText.Reset();
+		InitializeTextandFont();
+		log.LogCategorized("EVENT", "Hot reloaded font_consolas_32.xml");
+	}
+	void ReloadTexture(const std::string& file)
+	{
+		const std::wstring name(file.begin(), file.end());
+		for (size_t i = 0; i < ARRAYSIZE(texture_names); i++)
+		{
+			if (texture_names[i] != name)
+				continue;
+			ID3D11Device* creator;
+			d3d.GetDevice((void**)&creator);
+			// keep the old texture when the new file doesn't load (half written, bad format)
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> texture;
+			if (LoadTexture(creator, name, texture) == true)
+			{
+				shaderResourceView[i] = texture;
+				log.LogCategorized("EVENT", ("Hot reloaded " + file).c_str());
+			}
+			else
+				log.LogCategorized("ERROR", ("Hot reload could not load " + file).c_str());
+			creator->Release();
+		}
+	}
+	void PlayLoadingSound()
+	{
 		bool isPlayingFX;
 		loadingFX.isPlaying(isPlayingFX);
 		if (isPlayingFX == false)
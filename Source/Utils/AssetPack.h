@@ -0,0 +1,251 @@
+#ifndef _ASSETPACK_H_
+#define _ASSETPACK_H_
+#include "BlockCompression.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Single file asset archive (.pak), everything the game reads at start up in one mapping:
+//	HEADER | entries (sorted by hash) | names | file data
+// Files are stored as is or as a BlockCompression stream (COMPRESSED), each one starting
+// ALIGNMENT aligned, and looked up through a binary search over the 64 bit hashes of
+// their normalized paths, so opening a packed file is a lookup plus a pointer (and an
+// inflate for compressed ones), no file system call at all.
+// Paths are relative to the folder the pack was built in ("assets/arch.h2b"),
+// see NormalizePath. Little endian, like everything else we write.
+namespace AssetPack
+{
+	static constexpr char EXTENSION[] = ".pak";
+	static constexpr uint32_t VERSION = 2;
+	static constexpr uint32_t COMPRESSED = 1; // ENTRY::flags
+	static constexpr uint64_t ALIGNMENT = 16;
+	struct SECTION { uint64_t offset, count; };
+	struct HEADER
+	{
+		char magic[4]; // "APAK"
+		uint32_t version; // VERSION
+		SECTION entries; // ENTRY per file, sorted by hash
+		SECTION names; // NUL terminated normalized paths back to back
+		SECTION data; // file contents, count is in bytes
+	};
+	struct ENTRY
+	{
+		uint64_t hash; // HashPath of the normalized path
+		uint64_t offset, size; // bytes from the start of the pack, size once inflated
+		uint64_t stored; // bytes at offset, the stream length of compressed files
+		uint32_t name; // offset into the name section
+		uint32_t flags; // COMPRESSED
+	};
+
+	// '\\' -> '/', lower case, "." & ".." resolved, leading ".." dropped: "../Assets/Arch.h2b"
+	// and "Assets\\arch.H2B" both become "assets/arch.h2b" (the game runs one folder down)
+	inline std::string NormalizePath(std::string_view path) {
+		std::vector<std::string> parts;
+		size_t at = 0;
+		while (at <= path.size()) {
+			size_t end = path.find_first_of("/\\", at);
+			if (end == std::string_view::npos)
+				end = path.size();
+			std::string_view part = path.substr(at, end - at);
+			if (part == "..") {
+				if (parts.empty() == false)
+					parts.pop_back();
+			}
+			else if (part.empty() == false && part != ".") {
+				parts.emplace_back(part);
+				for (char& c : parts.back())
+					c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+			}
+			at = end + 1;
+		}
+		std::string out;
+		for (auto& part : parts)
+			out.append(out.empty() ? "" : "/").append(part);
+		return out;
+	}
+	inline uint64_t HashPath(std::string_view normalized) {
+		uint64_t hash = 14695981039346656037ull; // FNV-1a
+		for (char c : normalized) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// collects files from disk and writes them into a .pak
+	class Builder
+	{
+		struct SOURCE { std::string name, path; bool compress; };
+		std::vector<SOURCE> sources;
+	public:
+		// false if the pack already has a file with the same normalized name,
+		// "compress" files are only kept compressed when that saves at least 1/8
+		bool Add(std::string_view name, const std::string& path, bool compress = false) {
+			std::string normalized = NormalizePath(name);
+			for (auto& s : sources)
+				if (s.name == normalized)
+					return false;
+			sources.push_back({ std::move(normalized), path, compress });
+			return true;
+		}
+		size_t FileCount() const { return sources.size(); }
+		// uncompressed files are read once and streamed out, compressed ones are held until
+		// written, returns false on any read or write error
+		bool Write(const char* path, uint64_t* outDataBytes = nullptr, uint64_t* outRawBytes = nullptr) {
+			HEADER header = {};
+			std::memcpy(header.magic, "APAK", 4);
+			header.version = VERSION;
+			auto align = [](uint64_t at) { return (at + ALIGNMENT - 1) & ~(ALIGNMENT - 1); };
+			// table & names first, file offsets follow from the sizes on disk
+			std::vector<ENTRY> entries(sources.size());
+			std::vector<std::vector<unsigned char>> compressed(sources.size());
+			std::vector<char> names;
+			uint64_t rawBytes = 0;
+			for (size_t i = 0; i < sources.size(); ++i) {
+				unsigned long long size = 0;
+				long long modified = 0;
+				if (MappedFile::Stat(sources[i].path.c_str(), size, modified) == false)
+					return false;
+				entries[i] = { HashPath(sources[i].name), 0, size, size, static_cast<uint32_t>(names.size()), 0 };
+				rawBytes += size;
+				if (sources[i].compress && size > 0) {
+					MappedFile source;
+					if (source.Open(sources[i].path.c_str()) == false || source.Size() != size)
+						return false;
+					compressed[i] = BlockCompression::Compress(source.Data(), source.Size());
+					if (compressed[i].size() <= size - size / 8) {
+						entries[i].stored = compressed[i].size();
+						entries[i].flags = COMPRESSED;
+					}
+					else
+						compressed[i].clear(); // not worth an inflate on every open
+				}
+				names.insert(names.end(), sources[i].name.begin(), sources[i].name.end());
+				names.push_back('\0');
+			}
+			header.entries = { align(sizeof(HEADER)), entries.size() };
+			header.names = { align(header.entries.offset + entries.size() * sizeof(ENTRY)), names.size() };
+			uint64_t at = align(header.names.offset + names.size());
+			header.data.offset = at;
+			for (auto& e : entries) {
+				e.offset = at;
+				at = align(at + e.stored);
+			}
+			header.data.count = at - header.data.offset;
+			// sorting keeps each entry with its name & data, only the table order changes
+			std::vector<ENTRY> table = entries;
+			std::sort(table.begin(), table.end(), [](const ENTRY& a, const ENTRY& b) {
+				return a.hash < b.hash || (a.hash == b.hash && a.name < b.name); });
+
+			std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			if (file.is_open() == false)
+				return false;
+			const char zeros[ALIGNMENT] = {};
+			uint64_t written = 0;
+			auto put = [&](uint64_t offset, const void* data, uint64_t size) {
+				file.write(zeros, static_cast<std::streamsize>(offset - written)); // padding
+				file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+				written = offset + size;
+			};
+			put(0, &header, sizeof(header));
+			put(header.entries.offset, table.data(), table.size() * sizeof(ENTRY));
+			put(header.names.offset, names.data(), names.size());
+			for (size_t i = 0; i < sources.size() && file.good(); ++i) {
+				if (entries[i].flags & COMPRESSED) {
+					put(entries[i].offset, compressed[i].data(), compressed[i].size());
+					continue;
+				}
+				MappedFile source;
+				if (source.Open(sources[i].path.c_str()) == false || source.Size() != entries[i].size)
+					return false; // gone or changed while packing
+				put(entries[i].offset, source.Data(), source.Size());
+			}
+			put(header.data.offset + header.data.count, nullptr, 0); // pads the last file
+			if (outDataBytes != nullptr)
+				*outDataBytes = header.data.count;
+			if (outRawBytes != nullptr)
+				*outRawBytes = rawBytes;
+			return file.good();
+		}
+	};
+
+	// reads a .pak in place, every span stays valid until Close()
+	class View
+	{
+		MappedFile file;
+		const ENTRY* entries = nullptr;
+		const char* names = nullptr;
+		long long modified = 0;
+	public:
+		HEADER header = {};
+
+		// false if missing, truncated or anything points outside the file
+		bool Open(const char* path) {
+			Close();
+			unsigned long long size64 = 0;
+			if (MappedFile::Stat(path, size64, modified) == false ||
+				file.Open(path) == false || file.Size() < sizeof(HEADER))
+				return Fail();
+			const unsigned char* base = file.Data();
+			const size_t size = file.Size();
+			std::memcpy(&header, base, sizeof(header));
+			auto inBounds = [&](const SECTION& s, size_t stride) {
+				return s.offset <= size && s.count <= (size - s.offset) / stride;
+			};
+			if (std::memcmp(header.magic, "APAK", 4) != 0 || header.version != VERSION ||
+				inBounds(header.entries, sizeof(ENTRY)) == false || inBounds(header.names, 1) == false ||
+				inBounds(header.data, 1) == false || header.entries.offset % alignof(ENTRY) != 0 ||
+				(header.names.count > 0 && base[header.names.offset + header.names.count - 1] != '\0'))
+				return Fail();
+			entries = reinterpret_cast<const ENTRY*>(base + header.entries.offset);
+			names = reinterpret_cast<const char*>(base + header.names.offset);
+			for (uint64_t i = 0; i < header.entries.count; ++i) {
+				const ENTRY& e = entries[i];
+				if (e.name >= header.names.count || e.offset > size || e.stored > size - e.offset ||
+					((e.flags & COMPRESSED) == 0 && e.stored != e.size) ||
+					(i > 0 && entries[i - 1].hash > e.hash))
+					return Fail();
+			}
+			return true;
+		}
+		void Close() {
+			file.Close();
+			header = {};
+			entries = nullptr;
+			names = nullptr;
+			modified = 0;
+		}
+		bool IsOpen() const { return entries != nullptr; }
+		size_t FileCount() const { return static_cast<size_t>(header.entries.count); }
+		long long Modified() const { return modified; } // of the pack, stands in for every file in it
+		const char* Name(size_t i) const { return names + entries[i].name; }
+		// the entry stored under "path" (any spelling NormalizePath accepts) or nullptr
+		const ENTRY* Find(std::string_view path) const {
+			if (IsOpen() == false)
+				return nullptr;
+			const std::string normalized = NormalizePath(path);
+			const uint64_t hash = HashPath(normalized);
+			const ENTRY* end = entries + header.entries.count;
+			const ENTRY* e = std::lower_bound(entries, end, hash,
+				[](const ENTRY& entry, uint64_t h) { return entry.hash < h; });
+			for (; e != end && e->hash == hash; ++e)
+				if (normalized == names + e->name)
+					return e;
+			return nullptr;
+		}
+		// the stored bytes, a BlockCompression stream for COMPRESSED entries
+		const unsigned char* Data(const ENTRY& e) const { return file.Data() + e.offset; }
+		static bool Compressed(const ENTRY& e) { return (e.flags & COMPRESSED) != 0; }
+	private:
+		bool Fail() {
+			Close();
+			return false;
+		}
+	};
+}
+#endif
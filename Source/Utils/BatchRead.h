@@ -0,0 +1,400 @@
+#ifndef _BATCHREAD_H_
+#define _BATCHREAD_H_
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ParallelFor.h"
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+		#include <linux/io_uring.h>
+		#include <sys/mman.h>
+		#include <sys/syscall.h>
+		#define BATCHREAD_URING 1
+	#endif
+#endif
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+	#include <coroutine>
+	#define BATCHREAD_COROUTINES 1
+#endif
+
+// Reads a whole set of files into buffers of their own in one go, so the latency of
+// every open/read (cold disks, network shares) overlaps instead of adding up.
+// Linux submits all reads as one io_uring batch and hands each file out the moment its
+// last byte lands, everything else (or a kernel without io_uring) reads with a small
+// pool of threads doing pread / ReadFile, which keeps several requests in flight as well.
+//	std::vector<BatchRead::REQUEST> files = ...;
+//	BatchRead::ReadAll(files, [&](size_t i) { if (files[i].ok) Parse(files[i].bytes); });
+// ready(i) is called exactly once per file, failed ones included, as soon as it is done.
+// With the thread pool it may run on several threads at once, so only touch file i.
+namespace BatchRead
+{
+	static constexpr unsigned QUEUE_DEPTH = 64; // reads in flight at once on io_uring
+	static constexpr unsigned IO_THREADS = 8; // fallback readers, blocked on I/O most of the time
+	static constexpr size_t MAX_READ = 1u << 30; // bytes per request, bigger files take several
+	struct REQUEST
+	{
+		std::string path;
+		std::vector<unsigned char> bytes; // the whole file once ok
+		bool ok = false;
+	};
+	struct STATS
+	{
+		uint64_t files = 0, failed = 0, bytes = 0;
+		double seconds = 0.0;
+		bool uring = false; // false means the thread pool did the reading
+		double MBps() const { return (seconds > 0.0) ? bytes / (1024.0 * 1024.0) / seconds : 0.0; }
+	};
+
+	namespace Detail
+	{
+		// the portable path: open, size, read everything, close
+		inline bool ReadWhole(const char* path, std::vector<unsigned char>& out)
+		{
+#if defined(_WIN32)
+			HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER fileSize;
+			bool ok = GetFileSizeEx(file, &fileSize) != FALSE;
+			if (ok) {
+				out.resize(static_cast<size_t>(fileSize.QuadPart));
+				for (size_t done = 0; ok && done < out.size(); ) {
+					DWORD got = 0;
+					DWORD ask = static_cast<DWORD>((std::min)(out.size() - done, MAX_READ)); // windows.h may define min
+					ok = ReadFile(file, out.data() + done, ask, &got, nullptr) != FALSE && got != 0;
+					done += got;
+				}
+			}
+			CloseHandle(file);
+			return ok;
+#else
+			int fd = open(path, O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				return false;
+			struct stat info;
+			bool ok = fstat(fd, &info) == 0;
+			if (ok) {
+				out.resize(static_cast<size_t>(info.st_size));
+				for (size_t done = 0; ok && done < out.size(); ) {
+					ssize_t got = pread(fd, out.data() + done, std::min(out.size() - done, MAX_READ),
+						static_cast<off_t>(done));
+					if (got < 0 && errno == EINTR)
+						continue;
+					ok = got > 0; // 0 means the file shrank under us
+					done += (got > 0) ? static_cast<size_t>(got) : 0;
+				}
+			}
+			close(fd);
+			return ok;
+#endif
+		}
+
+#if defined(BATCHREAD_URING)
+		// Minimal io_uring: one submission and one completion ring, raw syscalls so
+		// nothing beyond the kernel headers is needed. Only used from one thread.
+		class Ring
+		{
+			int fd = -1;
+			void* sqMap = MAP_FAILED; size_t sqMapSize = 0;
+			void* cqMap = MAP_FAILED; size_t cqMapSize = 0;
+			io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED); size_t sqesSize = 0;
+			unsigned* sqHead = nullptr; unsigned* sqTail = nullptr; unsigned* sqMask = nullptr; unsigned* sqArray = nullptr;
+			unsigned* cqHead = nullptr; unsigned* cqTail = nullptr; unsigned* cqMask = nullptr;
+			io_uring_cqe* cqes = nullptr;
+			unsigned entries = 0;
+			unsigned queued = 0; // pushed but not yet passed to io_uring_enter
+			template<typename T> static T* At(void* map, unsigned offset) {
+				return reinterpret_cast<T*>(static_cast<unsigned char*>(map) + offset);
+			}
+		public:
+			Ring() = default;
+			~Ring() { Close(); }
+			Ring(const Ring&) = delete;
+			Ring& operator=(const Ring&) = delete;
+
+			bool Open(unsigned depth)
+			{
+				io_uring_params params;
+				std::memset(&params, 0, sizeof(params));
+				fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+				if (fd < 0)
+					return false; // old kernel, seccomp or disabled by sysctl
+				sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+				cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+				if (single)
+					sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+				sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+				if (sqMap == MAP_FAILED) {
+					Close();
+					return false;
+				}
+				cqMap = single ? sqMap : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+				sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+				sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+				if (cqMap == MAP_FAILED || sqes == MAP_FAILED) {
+					Close();
+					return false;
+				}
+				sqHead = At<unsigned>(sqMap, params.sq_off.head);
+				sqTail = At<unsigned>(sqMap, params.sq_off.tail);
+				sqMask = At<unsigned>(sqMap, params.sq_off.ring_mask);
+				sqArray = At<unsigned>(sqMap, params.sq_off.array);
+				cqHead = At<unsigned>(cqMap, params.cq_off.head);
+				cqTail = At<unsigned>(cqMap, params.cq_off.tail);
+				cqMask = At<unsigned>(cqMap, params.cq_off.ring_mask);
+				cqes = At<io_uring_cqe>(cqMap, params.cq_off.cqes);
+				entries = params.sq_entries;
+				return true;
+			}
+			void Close()
+			{
+				if (sqes != MAP_FAILED)
+					munmap(sqes, sqesSize);
+				if (cqMap != MAP_FAILED && cqMap != sqMap)
+					munmap(cqMap, cqMapSize);
+				if (sqMap != MAP_FAILED)
+					munmap(sqMap, sqMapSize);
+				if (fd >= 0)
+					close(fd);
+				fd = -1;
+				sqMap = cqMap = MAP_FAILED;
+				sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+				entries = queued = 0;
+			}
+			unsigned Entries() const { return entries; }
+			// queues a read, false when the submission ring is full
+			bool Read(int file, void* destination, unsigned length, uint64_t offset, uint64_t userData)
+			{
+				const unsigned tail = *sqTail;
+				if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= entries)
+					return false;
+				const unsigned slot = tail & *sqMask;
+				io_uring_sqe& sqe = sqes[slot];
+				std::memset(&sqe, 0, sizeof(sqe));
+				sqe.opcode = IORING_OP_READ;
+				sqe.fd = file;
+				sqe.addr = reinterpret_cast<uint64_t>(destination);
+				sqe.len = length;
+				sqe.off = offset;
+				sqe.user_data = userData;
+				sqArray[slot] = slot;
+				__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+				++queued;
+				return true;
+			}
+			// hands everything queued to the kernel and sleeps until at least "waitFor" reads completed
+			bool Submit(unsigned waitFor)
+			{
+				for (;;) {
+					long result = syscall(__NR_io_uring_enter, fd, queued, waitFor,
+						(waitFor != 0) ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+					if (result >= 0) {
+						queued -= std::min(queued, static_cast<unsigned>(result));
+						return true;
+					}
+					if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+						return false;
+				}
+			}
+			// reads queued since the last successful Submit, the kernel hasn't seen them
+			unsigned Unsubmitted() const { return queued; }
+			// sleeps until at least one completion is posted, without submitting anything
+			bool Wait()
+			{
+				return syscall(__NR_io_uring_enter, fd, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0) >= 0 || errno == EINTR;
+			}
+			// takes one finished read off the completion ring
+			bool Complete(uint64_t& userData, int& result)
+			{
+				const unsigned head = *cqHead;
+				if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+					return false;
+				const io_uring_cqe& cqe = cqes[head & *cqMask];
+				userData = cqe.user_data;
+				result = cqe.res;
+				__atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+				return true;
+			}
+		};
+
+		// every file is opened and sized up front, then reads stream through the ring.
+		// False only if the ring can't be used at all, nothing has been handed out then.
+		template<typename Ready>
+		bool ReadUring(std::vector<REQUEST>& files, Ready& ready)
+		{
+			Ring ring;
+			if (ring.Open(QUEUE_DEPTH) == false)
+				return false;
+			struct PENDING { int fd = -1; size_t done = 0; bool failed = false; };
+			std::vector<PENDING> pending(files.size());
+			std::vector<size_t> work; // files still waiting for their (next) request
+			size_t remaining = files.size();
+			auto finish = [&](size_t i, bool ok) {
+				if (pending[i].fd >= 0)
+					close(pending[i].fd);
+				pending[i].fd = -1;
+				files[i].ok = ok;
+				if (ok == false)
+					files[i].bytes = std::vector<unsigned char>();
+				--remaining;
+				ready(i);
+			};
+			for (size_t i = 0; i < files.size(); ++i) {
+				files[i].ok = false;
+				int fd = open(files[i].path.c_str(), O_RDONLY | O_CLOEXEC);
+				struct stat info;
+				if (fd >= 0 && fstat(fd, &info) == 0) {
+					pending[i].fd = fd;
+					files[i].bytes.resize(static_cast<size_t>(info.st_size));
+					work.push_back(i);
+				}
+				else {
+					if (fd >= 0)
+						close(fd);
+					pending[i].failed = true;
+				}
+			}
+			std::reverse(work.begin(), work.end()); // popped from the back, keep the callers order
+			unsigned inFlight = 0;
+			for (size_t i = 0; i < files.size(); ++i)
+				if (pending[i].failed)
+					finish(i, false);
+			while (remaining != 0) {
+				while (work.empty() == false && inFlight < ring.Entries()) {
+					const size_t i = work.back();
+					if (pending[i].done == files[i].bytes.size()) { // empty file
+						work.pop_back();
+						finish(i, true);
+						continue;
+					}
+					const size_t length = std::min(files[i].bytes.size() - pending[i].done, MAX_READ);
+					if (ring.Read(pending[i].fd, files[i].bytes.data() + pending[i].done,
+						static_cast<unsigned>(length), pending[i].done, i) == false)
+						break;
+					work.pop_back();
+					++inFlight;
+				}
+				if (inFlight == 0)
+					continue; // only empty files were left
+				if (ring.Submit(1) == false) {
+					// The ring broke mid way, read whatever is outstanding the blocking way. Reads the
+					// kernel already took may still write into their buffers, wait those out first
+					// so neither the fallback nor ready() gets a buffer that is still a target.
+					unsigned taken = inFlight - ring.Unsubmitted();
+					uint64_t userData;
+					int result;
+					while (taken != 0) {
+						if (ring.Complete(userData, result))
+							--taken;
+						else if (ring.Wait() == false)
+							std::this_thread::yield(); // completions are posted to the ring regardless, poll
+					}
+					for (size_t i = 0; i < files.size(); ++i)
+						if (pending[i].fd >= 0)
+							finish(i, ReadWhole(files[i].path.c_str(), files[i].bytes));
+					return true;
+				}
+				uint64_t userData;
+				int result;
+				while (ring.Complete(userData, result)) {
+					const size_t i = static_cast<size_t>(userData);
+					--inFlight;
+					if (result == -EINTR || result == -EAGAIN)
+						work.push_back(i); // try that part again
+					else if (result == -EINVAL || result == -EOPNOTSUPP)
+						finish(i, ReadWhole(files[i].path.c_str(), files[i].bytes)); // no IORING_OP_READ before 5.6
+					else if (result <= 0)
+						finish(i, false); // error, or the file shrank under us
+					else if ((pending[i].done += static_cast<size_t>(result)) == files[i].bytes.size())
+						finish(i, true); // parsing starts while the other reads are still in flight
+					else
+						work.push_back(i); // short read, queue the rest
+				}
+			}
+			return true;
+		}
+#endif
+	}
+
+	// reads files[i].path into files[i].bytes for every file, calling ready(i) for each as
+	// soon as it is done. Returns once all are. maxThreads only limits the thread pool path.
+	template<typename Ready>
+	STATS ReadAll(std::vector<REQUEST>& files, Ready&& ready, unsigned maxThreads = 0, bool allowUring = true)
+	{
+		auto start = std::chrono::steady_clock::now();
+		STATS stats;
+		stats.files = files.size();
+		std::atomic<uint64_t> bytes(0), failed(0);
+		auto done = [&](size_t i) { // counted before ready() can move the bytes away
+			bytes += files[i].bytes.size();
+			failed += files[i].ok ? 0 : 1;
+			ready(i);
+		};
+#if defined(BATCHREAD_URING)
+		stats.uring = allowUring && files.empty() == false && Detail::ReadUring(files, done);
+#else
+		(void)allowUring;
+#endif
+		if (stats.uring == false)
+			ParallelFor(files.size(), [&](size_t i) {
+				files[i].ok = Detail::ReadWhole(files[i].path.c_str(), files[i].bytes);
+				if (files[i].ok == false)
+					files[i].bytes = std::vector<unsigned char>();
+				done(i);
+			}, (maxThreads != 0) ? maxThreads : IO_THREADS);
+		stats.bytes = bytes;
+		stats.failed = failed;
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+
+#if defined(BATCHREAD_COROUTINES)
+	// C++20 callers can await a batch instead of blocking on it:
+	//	BatchRead::STATS stats = co_await BatchRead::Async(files, ready);
+	// The reads run on a thread of their own and the coroutine resumes on that thread
+	// once every file is done. files and ready must outlive the co_await.
+	template<typename Ready>
+	struct AWAIT_ALL
+	{
+		std::vector<REQUEST>* files;
+		Ready ready;
+		unsigned maxThreads;
+		STATS stats;
+		bool await_ready() const noexcept { return files->empty(); }
+		void await_suspend(std::coroutine_handle<> waiting)
+		{
+			std::thread([this, waiting]() {
+				stats = ReadAll(*files, ready, maxThreads);
+				waiting.resume();
+			}).detach();
+		}
+		STATS await_resume() const noexcept { return stats; }
+	};
+	template<typename Ready>
+	AWAIT_ALL<std::decay_t<Ready>> Async(std::vector<REQUEST>& files, Ready&& ready, unsigned maxThreads = 0)
+	{
+		return { &files, std::forward<Ready>(ready), maxThreads, STATS() };
+	}
+#endif
+}
+#endif
@@ -0,0 +1,344 @@
+#ifndef _BLOCKCOMPRESSION_H_
+#define _BLOCKCOMPRESSION_H_
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "ParallelFor.h"
+
+// LZ4 style byte oriented compression for cooked payloads (geometry in .lvlbin, textures
+// and models in .pak). A payload is cut into independent blocks so any number of threads
+// can inflate one straight into its final buffer, each block writing only its own range:
+//	STREAM | uint32 per block (stored bytes, STORED bit = kept raw) | blocks back to back
+// Each block is a run of LZ4 sequences (token, literals, 16 bit offset, match length),
+// blocks that would not shrink are kept raw. Little endian like everything else we write.
+namespace BlockCompression
+{
+	static constexpr uint32_t MIN_BLOCK_SIZE = 64 * 1024;
+	static constexpr uint32_t DEFAULT_BLOCK_SIZE = 128 * 1024;
+	static constexpr uint32_t MAX_BLOCK_SIZE = 256 * 1024;
+	static constexpr uint32_t STORED = 0x80000000u;
+	struct STREAM
+	{
+		char magic[4]; // "BLZ1"
+		uint32_t blockSize; // raw bytes per block, the last one may be shorter
+		uint64_t rawSize; // bytes once inflated
+		uint64_t blockCount;
+	};
+	// one payload to inflate, "packed" is a whole stream as written by Compress()
+	struct JOB
+	{
+		const unsigned char* packed;
+		size_t packedSize;
+		void* destination;
+		size_t rawSize;
+	};
+	struct STATS
+	{
+		uint64_t rawBytes = 0, packedBytes = 0, blocks = 0;
+		double seconds = 0.0; // wall clock
+		double busySeconds = 0.0; // summed over every thread, the time one core would need
+		unsigned threads = 0;
+		double MBps() const { return (seconds > 0.0) ? rawBytes / (1024.0 * 1024.0) / seconds : 0.0; }
+		double MBpsPerCore() const { return (busySeconds > 0.0) ? rawBytes / (1024.0 * 1024.0) / busySeconds : 0.0; }
+		void Add(const STATS& other) {
+			rawBytes += other.rawBytes;
+			packedBytes += other.packedBytes;
+			blocks += other.blocks;
+			seconds += other.seconds;
+			busySeconds += other.busySeconds;
+			threads = std::max(threads, other.threads);
+		}
+	};
+
+	namespace Detail
+	{
+		static constexpr unsigned MIN_MATCH = 4;
+		static constexpr unsigned LAST_LITERALS = 5; // a block always ends on literals
+		static constexpr unsigned MATCH_LIMIT = 12; // no match starts this close to the end
+		static constexpr unsigned HASH_BITS = 14;
+
+		inline uint32_t Read32(const unsigned char* at) { uint32_t v; std::memcpy(&v, at, 4); return v; }
+		inline uint64_t Read64(const unsigned char* at) { uint64_t v; std::memcpy(&v, at, 8); return v; }
+		inline uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+		// 255 continues, anything less ends the length
+		inline unsigned char* PutLength(unsigned char* out, size_t length) {
+			for (; length >= 255; length -= 255)
+				*out++ = 255;
+			*out++ = static_cast<unsigned char>(length);
+			return out;
+		}
+		inline bool GetLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+			for (;;) {
+				if (in == end)
+					return false;
+				const unsigned char byte = *in++;
+				length += byte;
+				if (byte != 255)
+					return true;
+			}
+		}
+
+		// compressed size, 0 if the result would not fit in "capacity"
+		inline size_t CompressBlock(const unsigned char* src, size_t size, unsigned char* dst, size_t capacity) {
+			uint32_t table[1u << HASH_BITS] = {}; // block positions + 1, 0 = empty
+			unsigned char* op = dst;
+			unsigned char* const oend = dst + capacity;
+			size_t anchor = 0, ip = 0;
+			auto emit = [&](size_t literals, size_t offset, size_t match) -> bool {
+				// worst case token + literal length bytes + literals + offset + match length bytes
+				if (static_cast<size_t>(oend - op) < 1 + literals / 255 + 1 + literals + 2 + match / 255 + 1)
+					return false;
+				unsigned char* token = op++;
+				*token = static_cast<unsigned char>(std::min<size_t>(literals, 15) << 4);
+				if (literals >= 15)
+					op = PutLength(op, literals - 15);
+				std::memcpy(op, src + anchor, literals);
+				op += literals;
+				if (match == 0)
+					return true; // last literals
+				*op++ = static_cast<unsigned char>(offset);
+				*op++ = static_cast<unsigned char>(offset >> 8);
+				match -= MIN_MATCH;
+				*token |= static_cast<unsigned char>(std::min<size_t>(match, 15));
+				if (match >= 15)
+					op = PutLength(op, match - 15);
+				return true;
+			};
+			if (size > MATCH_LIMIT) {
+				const size_t matchLimit = size - MATCH_LIMIT;
+				const size_t extendLimit = size - LAST_LITERALS;
+				while (ip < matchLimit) {
+					const uint32_t sequence = Read32(src + ip);
+					uint32_t& slot = table[Hash(sequence)];
+					const size_t candidate = slot;
+					slot = static_cast<uint32_t>(ip + 1);
+					if (candidate == 0 || ip + 1 - candidate > 0xFFFF || Read32(src + candidate - 1) != sequence) {
+						ip += 1 + ((ip - anchor) >> 6); // skip faster through data that doesn't match
+						continue;
+					}
+					size_t ref = candidate - 1;
+					while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+						--ip; // grow the match backwards into the pending literals
+						--ref;
+					}
+					size_t length = MIN_MATCH;
+					while (ip + length + 8 <= extendLimit) {
+						const uint64_t diff = Read64(src + ip + length) ^ Read64(src + ref + length);
+						if (diff != 0)
+							break;
+						length += 8;
+					}
+					while (ip + length < extendLimit && src[ip + length] == src[ref + length])
+						++length;
+					if (emit(ip - anchor, ip - ref, length) == false)
+						return 0;
+					ip += length;
+					anchor = ip;
+					if (ip >= 2 && ip - 2 < matchLimit)
+						table[Hash(Read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2 + 1);
+				}
+			}
+			if (emit(size - anchor, 0, 0) == false)
+				return 0;
+			return static_cast<size_t>(op - dst);
+		}
+		// false on anything that would read or write out of range or not fill "dst" exactly
+		inline bool DecompressBlock(const unsigned char* src, size_t size, unsigned char* dst, size_t rawSize) {
+			const unsigned char* ip = src;
+			const unsigned char* const iend = src + size;
+			unsigned char* op = dst;
+			unsigned char* const oend = dst + rawSize;
+			while (ip < iend) {
+				const unsigned token = *ip++;
+				size_t literals = token >> 4;
+				if (literals == 15 && GetLength(ip, iend, literals) == false)
+					return false;
+				if (literals > static_cast<size_t>(iend - ip) || literals > static_cast<size_t>(oend - op))
+					return false;
+				if (iend - ip >= 16 && oend - op >= 16 && literals <= 16)
+					std::memcpy(op, ip, 16); // fixed size copy, the extra bytes get overwritten
+				else
+					std::memcpy(op, ip, literals);
+				ip += literals;
+				op += literals;
+				if (ip == iend)
+					break; // the last sequence has no match
+				if (iend - ip < 2)
+					return false;
+				const size_t offset = ip[0] | (ip[1] << 8);
+				ip += 2;
+				size_t match = token & 15;
+				if (match == 15 && GetLength(ip, iend, match) == false)
+					return false;
+				match += MIN_MATCH;
+				if (offset == 0 || offset > static_cast<size_t>(op - dst) || match > static_cast<size_t>(oend - op))
+					return false;
+				const unsigned char* ref = op - offset;
+				if (offset >= 16 && match <= 16 && oend - op >= 16)
+					std::memcpy(op, ref, 16); // same trick for the common short match
+				else if (offset >= 8) { // 8 bytes at a time, each chunk only reads bytes already written
+					size_t i = 0;
+					for (; i + 8 <= match; i += 8)
+						std::memcpy(op + i, ref + i, 8);
+					for (; i < match; ++i)
+						op[i] = ref[i];
+				}
+				else { // short repeats overlap their own output
+					for (size_t i = 0; i < match; ++i)
+						op[i] = ref[i];
+				}
+				op += match;
+			}
+			return op == oend;
+		}
+		// copies out a stream header that is safe to walk: known magic, a block size we write,
+		// the block count rawSize implies and a block table that fits in "packedSize"
+		inline bool ReadHeader(const unsigned char* packed, size_t packedSize, STREAM& stream) {
+			if (packedSize < sizeof(STREAM))
+				return false;
+			std::memcpy(&stream, packed, sizeof(STREAM));
+			return std::memcmp(stream.magic, "BLZ1", 4) == 0 &&
+				stream.blockSize >= MIN_BLOCK_SIZE && stream.blockSize <= MAX_BLOCK_SIZE &&
+				stream.rawSize <= UINT64_MAX - stream.blockSize &&
+				stream.blockCount == (stream.rawSize + stream.blockSize - 1) / stream.blockSize &&
+				stream.blockCount <= (packedSize - sizeof(STREAM)) / sizeof(uint32_t);
+		}
+	}
+
+	inline uint32_t ClampBlockSize(uint32_t blockSize) {
+		return std::min(MAX_BLOCK_SIZE, std::max(MIN_BLOCK_SIZE, blockSize));
+	}
+	// whole stream for "size" bytes, blocks are compressed in parallel
+	inline std::vector<unsigned char> Compress(const void* data, size_t size,
+		uint32_t blockSize = DEFAULT_BLOCK_SIZE, unsigned maxThreads = 0) {
+		blockSize = ClampBlockSize(blockSize);
+		const unsigned char* src = static_cast<const unsigned char*>(data);
+		STREAM stream = {};
+		std::memcpy(stream.magic, "BLZ1", 4);
+		stream.blockSize = blockSize;
+		stream.rawSize = size;
+		stream.blockCount = (size + blockSize - 1) / blockSize;
+		const size_t blocks = static_cast<size_t>(stream.blockCount);
+		std::vector<std::vector<unsigned char>> packed(blocks);
+		std::vector<uint32_t> sizes(blocks);
+		ParallelFor(blocks, [&](size_t b) {
+			const size_t at = b * blockSize;
+			const size_t length = std::min<size_t>(blockSize, size - at);
+			packed[b].resize(length - 1); // anything not at least one byte smaller is stored
+			size_t bytes = (length > 1) ? Detail::CompressBlock(src + at, length, packed[b].data(), packed[b].size()) : 0;
+			if (bytes == 0) {
+				packed[b].assign(src + at, src + at + length);
+				sizes[b] = static_cast<uint32_t>(length) | STORED;
+			}
+			else {
+				packed[b].resize(bytes);
+				sizes[b] = static_cast<uint32_t>(bytes);
+			}
+		}, maxThreads);
+		size_t total = sizeof(STREAM) + blocks * sizeof(uint32_t);
+		for (auto& p : packed)
+			total += p.size();
+		std::vector<unsigned char> out;
+		out.reserve(total);
+		const unsigned char* header = reinterpret_cast<const unsigned char*>(&stream);
+		out.insert(out.end(), header, header + sizeof(STREAM));
+		const unsigned char* table = reinterpret_cast<const unsigned char*>(sizes.data());
+		out.insert(out.end(), table, table + blocks * sizeof(uint32_t));
+		for (auto& p : packed)
+			out.insert(out.end(), p.begin(), p.end());
+		return out;
+	}
+	// raw size a stream inflates to, false if "packed" doesn't start with a valid stream header
+	inline bool RawSize(const unsigned char* packed, size_t packedSize, uint64_t& outSize) {
+		STREAM stream;
+		if (Detail::ReadHeader(packed, packedSize, stream) == false)
+			return false;
+		outSize = stream.rawSize;
+		return true;
+	}
+	// Inflates every job, all blocks of all jobs share one set of worker threads.
+	// Returns false if any stream is malformed or doesn't match its rawSize, in which case
+	// the destinations hold garbage.
+	inline bool Decompress(const std::vector<JOB>& jobs, STATS* outStats = nullptr, unsigned maxThreads = 0) {
+		struct BLOCK { const unsigned char* src; size_t srcSize; unsigned char* dst; size_t dstSize; bool stored; };
+		std::vector<BLOCK> blocks;
+		STATS stats;
+		const auto start = std::chrono::steady_clock::now();
+		for (const JOB& job : jobs) {
+			STREAM stream;
+			if (Detail::ReadHeader(job.packed, job.packedSize, stream) == false || stream.rawSize != job.rawSize)
+				return false;
+			const unsigned char* table = job.packed + sizeof(STREAM);
+			size_t at = sizeof(STREAM) + static_cast<size_t>(stream.blockCount) * sizeof(uint32_t);
+			unsigned char* dst = static_cast<unsigned char*>(job.destination);
+			for (uint64_t b = 0; b < stream.blockCount; ++b) {
+				uint32_t entry;
+				std::memcpy(&entry, table + b * sizeof(uint32_t), sizeof(entry));
+				const size_t srcSize = entry & ~STORED;
+				const size_t offset = static_cast<size_t>(b) * stream.blockSize;
+				const size_t dstSize = std::min<size_t>(stream.blockSize, job.rawSize - offset);
+				if (srcSize > job.packedSize - at || ((entry & STORED) != 0 && srcSize != dstSize))
+					return false;
+				blocks.push_back({ job.packed + at, srcSize, dst + offset, dstSize, (entry & STORED) != 0 });
+				at += srcSize;
+			}
+			stats.rawBytes += job.rawSize;
+			stats.packedBytes += job.packedSize;
+		}
+		std::atomic<bool> ok(true);
+		std::atomic<long long> busy(0); // nanoseconds
+		ParallelFor(blocks.size(), [&](size_t i) {
+			const auto blockStart = std::chrono::steady_clock::now();
+			const BLOCK& b = blocks[i];
+			if (b.stored)
+				std::memcpy(b.dst, b.src, b.dstSize);
+			else if (Detail::DecompressBlock(b.src, b.srcSize, b.dst, b.dstSize) == false)
+				ok = false;
+			busy += std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - blockStart).count();
+		}, maxThreads);
+		if (outStats != nullptr) {
+			const unsigned threads = (maxThreads != 0) ? maxThreads : std::thread::hardware_concurrency();
+			stats.blocks = blocks.size();
+			stats.threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, blocks.size())));
+			stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			stats.busySeconds = busy * 1e-9;
+			*outStats = stats;
+		}
+		return ok;
+	}
+	inline bool Decompress(const unsigned char* packed, size_t packedSize, void* destination, size_t rawSize,
+		STATS* outStats = nullptr, unsigned maxThreads = 0) {
+		return Decompress(std::vector<JOB>{ { packed, packedSize, destination, rawSize } }, outStats, maxThreads);
+	}
+	// inflates just the first "bytes" of a payload (at most one block), e.g. to read a file header
+	inline bool DecompressPrefix(const unsigned char* packed, size_t packedSize, void* destination, size_t bytes) {
+		STREAM stream;
+		if (Detail::ReadHeader(packed, packedSize, stream) == false || bytes > stream.rawSize || bytes > stream.blockSize)
+			return false;
+		if (bytes == 0)
+			return true;
+		const size_t at = sizeof(STREAM) + static_cast<size_t>(stream.blockCount) * sizeof(uint32_t);
+		const uint32_t entry = Detail::Read32(packed + sizeof(STREAM));
+		const size_t srcSize = entry & ~STORED;
+		const size_t blockSize = static_cast<size_t>(std::min<uint64_t>(stream.blockSize, stream.rawSize));
+		if (srcSize > packedSize - at)
+			return false;
+		if ((entry & STORED) != 0) {
+			if (srcSize != blockSize)
+				return false;
+			std::memcpy(destination, packed + at, bytes);
+			return true;
+		}
+		std::vector<unsigned char> block(blockSize);
+		if (Detail::DecompressBlock(packed + at, srcSize, block.data(), blockSize) == false)
+			return false;
+		std::memcpy(destination, block.data(), bytes);
+		return true;
+	}
+}
+#endif
@@ -0,0 +1,184 @@
+#ifndef _BOUNDS_H_
+#define _BOUNDS_H_
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include "h2bParser.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BOUNDS_USE_SSE 1
+	#include <immintrin.h>
+#endif
+
+// Axis aligned boxes and spheres for culling, picking and collision.
+// The vertex reductions are 4 wide SSE (two vertices per step when built with AVX)
+// with a scalar fallback, instance volumes are transformed in batches straight
+// from the level's row major matrices.
+namespace Bounds {
+
+	struct VOLUME {
+		float min[4], max[4]; // w unused
+		float sphere[4]; // center xyz, radius w
+	};
+
+#if defined(BOUNDS_USE_SSE)
+	// x y z of a vertex position, w is whatever follows it in memory (ignored)
+	inline __m128 LoadPosition(const H2B::VERTEX& v) { return _mm_loadu_ps(&v.pos.x); }
+	inline float MaxLane(__m128 v) {
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2))));
+	}
+	inline float SumXYZ(__m128 v) {
+		return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)), _mm_shuffle_ps(v, v, 2)));
+	}
+#endif
+
+	// min/max and a sphere around whichever is smaller: the box center or the centroid.
+	// "position(i)" returns the i-th vertex, so whole models and indexed meshes share it.
+	template <typename Fetch>
+	VOLUME Compute(size_t count, Fetch position) {
+		VOLUME out = { { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } };
+		if (count == 0)
+			return out;
+#if defined(BOUNDS_USE_SSE)
+		__m128 lo = LoadPosition(position(0)), hi = lo, sum = _mm_setzero_ps();
+		size_t i = 0;
+	#if defined(__AVX__)
+		__m256 lo8 = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), lo, 1), hi8 = lo8, sum8 = _mm256_setzero_ps();
+		for (; i + 2 <= count; i += 2) {
+			__m256 p = _mm256_insertf128_ps(_mm256_castps128_ps256(LoadPosition(position(i))),
+				LoadPosition(position(i + 1)), 1);
+			lo8 = _mm256_min_ps(lo8, p);
+			hi8 = _mm256_max_ps(hi8, p);
+			sum8 = _mm256_add_ps(sum8, p);
+		}
+		lo = _mm_min_ps(_mm256_castps256_ps128(lo8), _mm256_extractf128_ps(lo8, 1));
+		hi = _mm_max_ps(_mm256_castps256_ps128(hi8), _mm256_extractf128_ps(hi8, 1));
+		sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+	#endif
+		for (; i < count; ++i) {
+			__m128 p = LoadPosition(position(i));
+			lo = _mm_min_ps(lo, p);
+			hi = _mm_max_ps(hi, p);
+			sum = _mm_add_ps(sum, p);
+		}
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 boxCenter = _mm_mul_ps(_mm_add_ps(lo, hi), half);
+		const __m128 centroid = _mm_mul_ps(sum, _mm_set1_ps(1.0f / count));
+		// squared distances four vertices at a time, transposed to x x x x / y y y y / z z z z
+		const __m128 bx = _mm_shuffle_ps(boxCenter, boxCenter, 0x00), by = _mm_shuffle_ps(boxCenter, boxCenter, 0x55),
+			bz = _mm_shuffle_ps(boxCenter, boxCenter, 0xAA);
+		const __m128 gx = _mm_shuffle_ps(centroid, centroid, 0x00), gy = _mm_shuffle_ps(centroid, centroid, 0x55),
+			gz = _mm_shuffle_ps(centroid, centroid, 0xAA);
+		__m128 boxRadius = _mm_setzero_ps(), centroidRadius = _mm_setzero_ps();
+		for (i = 0; i < count; i += 4) {
+			__m128 x = LoadPosition(position(i)), y = LoadPosition(position(std::min(i + 1, count - 1))),
+				z = LoadPosition(position(std::min(i + 2, count - 1))), w = LoadPosition(position(std::min(i + 3, count - 1)));
+			_MM_TRANSPOSE4_PS(x, y, z, w); // past the end repeats the last vertex, which changes nothing
+			__m128 dx = _mm_sub_ps(x, bx), dy = _mm_sub_ps(y, by), dz = _mm_sub_ps(z, bz);
+			boxRadius = _mm_max_ps(boxRadius, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+			dx = _mm_sub_ps(x, gx), dy = _mm_sub_ps(y, gy), dz = _mm_sub_ps(z, gz);
+			centroidRadius = _mm_max_ps(centroidRadius, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		}
+		_mm_storeu_ps(out.min, lo);
+		_mm_storeu_ps(out.max, hi);
+		const float boxRadius2 = MaxLane(boxRadius), centroidRadius2 = MaxLane(centroidRadius);
+		const bool useBox = boxRadius2 <= centroidRadius2;
+		_mm_storeu_ps(out.sphere, useBox ? boxCenter : centroid);
+		out.sphere[3] = std::sqrt(useBox ? boxRadius2 : centroidRadius2);
+#else
+		const H2B::VECTOR& first = position(0).pos;
+		float lo[3] = { first.x, first.y, first.z }, hi[3] = { first.x, first.y, first.z }, sum[3] = { 0, 0, 0 };
+		for (size_t i = 0; i < count; ++i) {
+			const float* p = &position(i).pos.x;
+			for (int k = 0; k < 3; ++k) {
+				lo[k] = std::min(lo[k], p[k]);
+				hi[k] = std::max(hi[k], p[k]);
+				sum[k] += p[k];
+			}
+		}
+		float boxCenter[3], centroid[3], boxRadius = 0.0f, centroidRadius = 0.0f;
+		for (int k = 0; k < 3; ++k) {
+			boxCenter[k] = (lo[k] + hi[k]) * 0.5f;
+			centroid[k] = sum[k] / count;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			const float* p = &position(i).pos.x;
+			float a = 0.0f, b = 0.0f;
+			for (int k = 0; k < 3; ++k) {
+				a += (p[k] - boxCenter[k]) * (p[k] - boxCenter[k]);
+				b += (p[k] - centroid[k]) * (p[k] - centroid[k]);
+			}
+			boxRadius = std::max(boxRadius, a);
+			centroidRadius = std::max(centroidRadius, b);
+		}
+		const bool useBox = boxRadius <= centroidRadius;
+		for (int k = 0; k < 3; ++k) {
+			out.min[k] = lo[k];
+			out.max[k] = hi[k];
+			out.sphere[k] = useBox ? boxCenter[k] : centroid[k];
+		}
+		out.sphere[3] = std::sqrt(useBox ? boxRadius : centroidRadius);
+#endif
+		out.min[3] = out.max[3] = 0.0f;
+		return out;
+	}
+	// every vertex of a model
+	inline VOLUME FromVertices(const H2B::VERTEX* vertices, size_t count) {
+		return Compute(count, [vertices](size_t i) -> const H2B::VERTEX& { return vertices[i]; });
+	}
+	// only the vertices an index range touches (repeats don't change the box, only the centroid)
+	inline VOLUME FromIndices(const H2B::VERTEX* vertices, const unsigned* indices, size_t indexCount) {
+		return Compute(indexCount, [vertices, indices](size_t i) -> const H2B::VERTEX& { return vertices[indices[i]]; });
+	}
+
+	// Model space volume -> world space volume for "count" row major 4x4 matrices
+	// (16 floats apart), row vector convention: p' = x*row1 + y*row2 + z*row3 + row4.
+	// The box is the tight box of the transformed box (|row| weighted extents), the
+	// sphere is scaled by the largest row length so it stays conservative under any scale.
+	inline void TransformVolumes(const VOLUME& local, const float* matrices, size_t count, VOLUME* out) {
+		const float center[3] = { (local.min[0] + local.max[0]) * 0.5f, (local.min[1] + local.max[1]) * 0.5f,
+			(local.min[2] + local.max[2]) * 0.5f };
+		const float extent[3] = { (local.max[0] - local.min[0]) * 0.5f, (local.max[1] - local.min[1]) * 0.5f,
+			(local.max[2] - local.min[2]) * 0.5f };
+#if defined(BOUNDS_USE_SSE)
+		const __m128 cx = _mm_set1_ps(center[0]), cy = _mm_set1_ps(center[1]), cz = _mm_set1_ps(center[2]);
+		const __m128 ex = _mm_set1_ps(extent[0]), ey = _mm_set1_ps(extent[1]), ez = _mm_set1_ps(extent[2]);
+		const __m128 sx = _mm_set1_ps(local.sphere[0]), sy = _mm_set1_ps(local.sphere[1]), sz = _mm_set1_ps(local.sphere[2]);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		for (size_t i = 0; i < count; ++i) {
+			const float* m = matrices + i * 16;
+			const __m128 r1 = _mm_loadu_ps(m), r2 = _mm_loadu_ps(m + 4), r3 = _mm_loadu_ps(m + 8), r4 = _mm_loadu_ps(m + 12);
+			__m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, r1), _mm_mul_ps(cy, r2)), _mm_add_ps(_mm_mul_ps(cz, r3), r4));
+			__m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_and_ps(r1, absMask)), _mm_mul_ps(ey, _mm_and_ps(r2, absMask))),
+				_mm_mul_ps(ez, _mm_and_ps(r3, absMask)));
+			__m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, r1), _mm_mul_ps(sy, r2)), _mm_add_ps(_mm_mul_ps(sz, r3), r4));
+			const float scale = std::sqrt(std::max(SumXYZ(_mm_mul_ps(r1, r1)),
+				std::max(SumXYZ(_mm_mul_ps(r2, r2)), SumXYZ(_mm_mul_ps(r3, r3)))));
+			VOLUME& v = out[i];
+			_mm_storeu_ps(v.min, _mm_sub_ps(c, e));
+			_mm_storeu_ps(v.max, _mm_add_ps(c, e));
+			_mm_storeu_ps(v.sphere, s);
+			v.min[3] = v.max[3] = 0.0f;
+			v.sphere[3] = local.sphere[3] * scale;
+		}
+#else
+		for (size_t i = 0; i < count; ++i) {
+			const float* m = matrices + i * 16;
+			VOLUME& v = out[i];
+			float scale = 0.0f;
+			for (int r = 0; r < 3; ++r)
+				scale = std::max(scale, m[r * 4] * m[r * 4] + m[r * 4 + 1] * m[r * 4 + 1] + m[r * 4 + 2] * m[r * 4 + 2]);
+			for (int k = 0; k < 3; ++k) {
+				float c = center[0] * m[k] + center[1] * m[4 + k] + center[2] * m[8 + k] + m[12 + k];
+				float e = extent[0] * std::fabs(m[k]) + extent[1] * std::fabs(m[4 + k]) + extent[2] * std::fabs(m[8 + k]);
+				v.min[k] = c - e;
+				v.max[k] = c + e;
+				v.sphere[k] = local.sphere[0] * m[k] + local.sphere[1] * m[4 + k] + local.sphere[2] * m[8 + k] + m[12 + k];
+			}
+			v.min[3] = v.max[3] = 0.0f;
+			v.sphere[3] = local.sphere[3] * std::sqrt(scale);
+		}
+#endif
+	}
+}
+#endif
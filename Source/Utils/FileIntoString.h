@@ -1,21 +1,17 @@
 #ifndef SHADER_AS_STRING_H
 #define SHADER_AS_STRING_H
+#include <iostream>
+#include <string>
+#include "VirtualFile.h"
 
-// Reads a file into an std::string 
+// Reads a file (loose or from the mounted asset pack) into an std::string 
 std::string ReadFileIntoString(const char* filePath)
 {
 	std::string output;
-	unsigned int stringLength = 0;
-	GW::SYSTEM::GFile file;
+	VirtualFile file;
 
-	file.Create();
-	file.GetFileSize(filePath, stringLength);
-
-	if (stringLength > 0 && +file.OpenBinaryRead(filePath))
-	{
-		output.resize(stringLength);
-		file.Read(&output[0], stringLength);
-	}
+	if (file.Open(filePath) && file.Size() > 0)
+		output.assign(file.Text());
 	else
 		std::cout << "ERROR: File \"" << filePath << "\" Not Found!" << std::endl;
 
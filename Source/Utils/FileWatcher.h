@@ -0,0 +1,139 @@
+#ifndef _FILEWATCHER_H_
+#define _FILEWATCHER_H_
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__linux__)
+	#include <cerrno>
+	#include <climits>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#else
+	#include <filesystem>
+#endif
+
+// Reports files that were written inside a few watched directories (not recursive).
+// Linux gets its events from inotify, everything else compares modification times
+// every scanInterval. Editors and exporters tend to write a file in several steps,
+// so a change is only handed out once the file has been quiet for settleTime.
+// Poll() never blocks, call it once per frame from the thread that owns the watcher.
+class FileWatcher
+{
+public:
+	struct CHANGE
+	{
+		std::string directory; // exactly as given to Watch()
+		std::string file; // name inside it
+	};
+	std::chrono::milliseconds settleTime{ 150 };
+	std::chrono::milliseconds scanInterval{ 500 }; // polling fallback only
+
+	FileWatcher() = default;
+	~FileWatcher() { Close(); }
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	bool Watch(const std::string& directory)
+	{
+#if defined(__linux__)
+		if (events < 0)
+			events = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (events < 0)
+			return false;
+		// closed after writing or renamed into place, deletes keep what is loaded
+		int wd = inotify_add_watch(events, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wd < 0)
+			return false;
+		directories[wd] = directory;
+#else
+		std::error_code error;
+		if (std::filesystem::is_directory(directory, error) == false)
+			return false;
+		directories.push_back(directory);
+		Scan(directory, false);
+#endif
+		return true;
+	}
+	bool IsWatching() const { return directories.empty() == false; }
+	// appends every change that has settled, each file at most once per call
+	void Poll(std::vector<CHANGE>& out)
+	{
+		const auto now = std::chrono::steady_clock::now();
+#if defined(__linux__)
+		alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+		for (;;) {
+			ssize_t length = (events < 0) ? -1 : read(events, buffer, sizeof(buffer));
+			if (length <= 0)
+				break; // EAGAIN, nothing left to read
+			for (char* at = buffer; at < buffer + length; ) {
+				const inotify_event* e = reinterpret_cast<const inotify_event*>(at);
+				auto dir = directories.find(e->wd);
+				if (e->len > 0 && (e->mask & IN_ISDIR) == 0 && dir != directories.end())
+					pending[dir->second + '\n' + e->name] = { dir->second, e->name, now };
+				at += sizeof(inotify_event) + e->len;
+			}
+		}
+#else
+		if (now - lastScan >= scanInterval) {
+			lastScan = now;
+			for (auto& dir : directories)
+				Scan(dir, true);
+		}
+#endif
+		for (auto i = pending.begin(); i != pending.end(); ) {
+			if (now - i->second.when >= settleTime) {
+				out.push_back({ i->second.directory, i->second.file });
+				i = pending.erase(i);
+			}
+			else
+				++i;
+		}
+	}
+	void Close()
+	{
+#if defined(__linux__)
+		if (events >= 0)
+			close(events); // drops every watch with it
+		events = -1;
+#else
+		modified.clear();
+#endif
+		directories.clear();
+		pending.clear();
+	}
+private:
+	struct PENDING
+	{
+		std::string directory, file;
+		std::chrono::steady_clock::time_point when; // of the latest event
+	};
+	std::unordered_map<std::string, PENDING> pending; // "directory\nfile" -> last event
+#if defined(__linux__)
+	int events = -1; // inotify descriptor
+	std::unordered_map<int, std::string> directories; // watch descriptor -> directory
+#else
+	std::vector<std::string> directories;
+	std::unordered_map<std::string, std::filesystem::file_time_type> modified; // "directory\nfile" -> last seen
+	std::chrono::steady_clock::time_point lastScan;
+
+	void Scan(const std::string& directory, bool report)
+	{
+		std::error_code error;
+		for (auto& entry : std::filesystem::directory_iterator(directory, error)) {
+			if (entry.is_regular_file(error) == false)
+				continue;
+			const std::string file = entry.path().filename().string();
+			const std::string key = directory + '\n' + file;
+			auto time = entry.last_write_time(error);
+			auto seen = modified.find(key);
+			if (seen != modified.end() && seen->second == time)
+				continue;
+			modified[key] = time;
+			if (report) // any new or newer file, the first scan only records
+				pending[key] = { directory, file, std::chrono::steady_clock::now() };
+		}
+	}
+#endif
+};
+#endif
@@ -1,4 +1,5 @@
 #include "Font.h"
+#include "VirtualFile.h"
 #include <iostream>
 
 Font::Font()
@@ -38,8 +39,11 @@ Font& Font::operator=(const Font& that)
 
 bool Font::LoadFromXML(std::string filepath)
 {
+	// loose or from the mounted asset pack
+	VirtualFile file;
 	tinyxml2::XMLDocument document;
-	tinyxml2::XMLError error_message = document.LoadFile(filepath.c_str());
+	tinyxml2::XMLError error_message = (file.Open(filepath.c_str()) == false) ? tinyxml2::XML_ERROR_FILE_NOT_FOUND :
+		document.Parse(reinterpret_cast<const char*>(file.Data()), file.Size());
 	if (error_message != tinyxml2::XML_SUCCESS)
 	{
 		std::cout << "XML file [" + filepath + "] did not load properly." << std::endl;
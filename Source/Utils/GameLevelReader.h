@@ -0,0 +1,108 @@
+#ifndef _GAMELEVELREADER_H_
+#define _GAMELEVELREADER_H_
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+
+// Single pass scanner for the GameLevel.txt layout written by the blender exporter:
+//	MESH
+//	Bag_Coins.001
+//	<Matrix 4x4 ( 0.9718,  0.0000, 0.2359, 0.0000)
+//	            (-0.0000,  1.0000, 0.0000, 0.0000)
+//	            ...>
+// Works straight on the file's bytes (no per line copies, no sscanf) and
+// tolerates what hand edits tend to introduce: CRLF, tabs, blank or # comment
+// lines, extra or missing spaces & commas, '+' signs, exponents and a matrix split
+// over any number of lines. Blocks other than MESH (CAMERA, LIGHT...) are skipped.
+namespace GameLevelReader
+{
+	inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; }
+	// one line without its line break, leading & trailing white space
+	inline std::string_view NextLine(const char*& at, const char* end) {
+		const char* first = at;
+		while (at < end && *at != '\n')
+			++at;
+		const char* last = at;
+		if (at < end)
+			++at; // past the '\n'
+		while (first < last && IsSpace(*first))
+			++first;
+		while (last > first && IsSpace(last[-1]))
+			--last;
+		return std::string_view(first, last - first);
+	}
+	// the 16 floats of a "<Matrix 4x4 (...) (...) (...) (...)>" block, row by row
+	inline bool ReadMatrix(const char*& at, const char* end, float (&out)[16]) {
+		const char* p = at;
+		for (int row = 0; row < 4; ++row) {
+			// skip "<Matrix 4x4" and line breaks, but never into a line that isn't part of the matrix
+			bool newLine = true;
+			while (p < end && *p != '(') {
+				if (*p == '\n')
+					newLine = true;
+				else if (IsSpace(*p) == false) {
+					if (newLine && *p != '<')
+						return false;
+					newLine = false;
+				}
+				++p;
+			}
+			if (p == end)
+				return false;
+			++p;
+			for (int col = 0; col < 4; ++col) {
+				while (p < end && (IsSpace(*p) || *p == ','))
+					++p;
+				if (p < end && *p == '+') // from_chars only takes '-'
+					++p;
+				auto result = std::from_chars(p, end, out[row * 4 + col]);
+				if (result.ec != std::errc())
+					return false;
+				p = result.ptr;
+			}
+			while (p < end && (IsSpace(*p) || *p == ','))
+				++p;
+			if (p == end || *p != ')')
+				return false;
+			++p;
+		}
+		while (p < end && *p != '\n' && *p != '>') // closing '>' is optional
+			++p;
+		if (p < end && *p == '>')
+			++p;
+		at = p;
+		return true;
+	}
+	// blender adds ".001" style suffixes to copies, everything before the last '.' is the model
+	inline std::string_view ModelName(std::string_view objectName) {
+		size_t dot = objectName.find_last_of('.');
+		return (dot == std::string_view::npos) ? objectName : objectName.substr(0, dot);
+	}
+	// Calls onMesh(std::string_view objectName, const float (&matrix)[16]) for every MESH
+	// block in file order, the name points into "text". Returns how many MESH blocks
+	// were malformed and skipped, scanning picks up again on the line after the bad one.
+	template <typename OnMesh>
+	size_t ParseMeshes(const char* text, size_t size, OnMesh&& onMesh) {
+		const char* at = text;
+		const char* end = text + size;
+		size_t malformed = 0;
+		while (at < end) {
+			std::string_view line = NextLine(at, end);
+			if (line != "MESH")
+				continue; // blank, comment, other blocks and their contents
+			std::string_view name;
+			while (at < end && (name.empty() || name[0] == '#')) // first real line is the name
+				name = NextLine(at, end);
+			float matrix[16];
+			const char* matrixStart = at;
+			if (name.empty() || name[0] == '#' || ReadMatrix(at, end, matrix) == false) {
+				++malformed;
+				at = matrixStart;
+				continue;
+			}
+			onMesh(name, matrix);
+		}
+		return malformed;
+	}
+}
+#endif
@@ -0,0 +1,182 @@
+#ifndef _LEVELLAYOUT_H_
+#define _LEVELLAYOUT_H_
+#include "GameLevelReader.h"
+#include "VirtualFile.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Binary level layout (.blvl), the MESH blocks of a GameLevel.txt without any text:
+//	HEADER | model table | name table | records | strings
+// Every section starts 16 byte aligned. Tables hold offsets into the string section and
+// records are grouped by model (file order inside each model), so a level is read
+// with one mapping and a single pass over the records, no number or name parsing.
+// Little endian, like everything else we write.
+namespace LevelLayout
+{
+	static constexpr char EXTENSION[] = ".blvl";
+	static constexpr uint32_t VERSION = 1;
+	struct SECTION { uint64_t offset, count; };
+	struct HEADER
+	{
+		char magic[4]; // "BLVL"
+		uint32_t version; // VERSION
+		SECTION models; // uint32_t string offset per model name (no .h2b)
+		SECTION names; // uint32_t string offset per blender object name
+		SECTION records; // RECORD per MESH block
+		SECTION strings; // NUL terminated names back to back
+	};
+	struct RECORD
+	{
+		uint32_t modelId, nameId;
+		float transform[12]; // rows of the row major 4x4, the last column is always 0,0,0,1
+	};
+
+	inline bool HasExtension(const char* path) {
+		std::string_view p = path;
+		std::string_view ext = EXTENSION;
+		return p.size() >= ext.size() && p.compare(p.size() - ext.size(), ext.size(), ext) == 0;
+	}
+	// 4x3 <-> 4x4, returns false when the matrix has a projective column that can't be stored
+	inline bool Compact(const float (&matrix)[16], float (&out)[12]) {
+		for (int row = 0; row < 4; ++row)
+			for (int col = 0; col < 3; ++col)
+				out[row * 3 + col] = matrix[row * 4 + col];
+		return matrix[3] == 0.0f && matrix[7] == 0.0f && matrix[11] == 0.0f && matrix[15] == 1.0f;
+	}
+	inline void Expand(const float (&compact)[12], float* out) {
+		for (int row = 0; row < 4; ++row) {
+			for (int col = 0; col < 3; ++col)
+				out[row * 4 + col] = compact[row * 3 + col];
+			out[row * 4 + 3] = (row == 3) ? 1.0f : 0.0f;
+		}
+	}
+
+	// collects MESH blocks and writes them out as a .blvl
+	class Builder
+	{
+		std::vector<char> strings;
+		std::vector<uint32_t> models, names;
+		std::unordered_map<std::string, uint32_t> modelIds, nameIds;
+		std::vector<RECORD> records;
+		size_t projective = 0;
+
+		static uint32_t Intern(std::string_view str, std::unordered_map<std::string, uint32_t>& ids,
+			std::vector<uint32_t>& table, std::vector<char>& strings) {
+			auto found = ids.emplace(std::string(str), static_cast<uint32_t>(table.size()));
+			if (found.second) {
+				table.push_back(static_cast<uint32_t>(strings.size()));
+				strings.insert(strings.end(), str.begin(), str.end());
+				strings.push_back('\0');
+			}
+			return found.first->second;
+		}
+	public:
+		void Add(std::string_view objectName, const float (&matrix)[16]) {
+			RECORD r;
+			r.modelId = Intern(GameLevelReader::ModelName(objectName), modelIds, models, strings);
+			r.nameId = Intern(objectName, nameIds, names, strings);
+			projective += Compact(matrix, r.transform) ? 0 : 1;
+			records.push_back(r);
+		}
+		size_t RecordCount() const { return records.size(); }
+		size_t ModelCount() const { return models.size(); }
+		size_t ProjectiveCount() const { return projective; } // matrices that lost their w column
+		// every MESH block of a GameLevel.txt, returns the number of malformed blocks skipped
+		size_t AddText(const char* text, size_t size) {
+			return GameLevelReader::ParseMeshes(text, size,
+				[&](std::string_view name, const float (&matrix)[16]) { Add(name, matrix); });
+		}
+		bool Write(const char* path) {
+			std::stable_sort(records.begin(), records.end(),
+				[](const RECORD& a, const RECORD& b) { return a.modelId < b.modelId; });
+			HEADER header = {};
+			std::memcpy(header.magic, "BLVL", 4);
+			header.version = VERSION;
+			std::vector<char> blob(sizeof(HEADER));
+			auto append = [&](SECTION& section, const void* data, size_t count, size_t stride) {
+				blob.resize((blob.size() + 15) & ~size_t(15));
+				section.offset = blob.size();
+				section.count = count;
+				const char* bytes = static_cast<const char*>(data);
+				blob.insert(blob.end(), bytes, bytes + count * stride);
+			};
+			append(header.models, models.data(), models.size(), sizeof(uint32_t));
+			append(header.names, names.data(), names.size(), sizeof(uint32_t));
+			append(header.records, records.data(), records.size(), sizeof(RECORD));
+			append(header.strings, strings.data(), strings.size(), 1);
+			std::memcpy(blob.data(), &header, sizeof(header));
+			std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			return file.is_open() && file.write(blob.data(), blob.size()).good();
+		}
+	};
+
+	// reads a .blvl in place (loose or packed), everything stays valid until Close()
+	class View
+	{
+		VirtualFile file;
+		const uint32_t* models = nullptr;
+		const uint32_t* names = nullptr;
+		const char* strings = nullptr;
+	public:
+		HEADER header = {};
+		const RECORD* records = nullptr;
+
+		// false if missing, truncated or anything points outside the file
+		bool Open(const char* path) {
+			Close();
+			if (file.Open(path) == false || file.Size() < sizeof(HEADER))
+				return Fail();
+			const unsigned char* base = file.Data();
+			const size_t size = file.Size();
+			std::memcpy(&header, base, sizeof(header));
+			auto inBounds = [&](const SECTION& s, size_t stride) {
+				return s.offset <= size && s.count <= (size - s.offset) / stride;
+			};
+			if (std::memcmp(header.magic, "BLVL", 4) != 0 || header.version != VERSION ||
+				inBounds(header.models, sizeof(uint32_t)) == false ||
+				inBounds(header.names, sizeof(uint32_t)) == false ||
+				inBounds(header.records, sizeof(RECORD)) == false ||
+				inBounds(header.strings, 1) == false ||
+				(header.strings.count > 0 && base[header.strings.offset + header.strings.count - 1] != '\0') ||
+				(header.models.offset | header.names.offset | header.records.offset) % alignof(RECORD) != 0)
+				return Fail();
+			models = reinterpret_cast<const uint32_t*>(base + header.models.offset);
+			names = reinterpret_cast<const uint32_t*>(base + header.names.offset);
+			records = reinterpret_cast<const RECORD*>(base + header.records.offset);
+			strings = reinterpret_cast<const char*>(base + header.strings.offset);
+			for (uint64_t i = 0; i < header.models.count; ++i)
+				if (models[i] >= header.strings.count)
+					return Fail();
+			for (uint64_t i = 0; i < header.names.count; ++i)
+				if (names[i] >= header.strings.count)
+					return Fail();
+			for (uint64_t i = 0; i < header.records.count; ++i)
+				if (records[i].modelId >= header.models.count || records[i].nameId >= header.names.count)
+					return Fail();
+			return true;
+		}
+		void Close() {
+			file.Close();
+			header = {};
+			models = names = nullptr;
+			strings = nullptr;
+			records = nullptr;
+		}
+		size_t ModelCount() const { return static_cast<size_t>(header.models.count); }
+		size_t RecordCount() const { return static_cast<size_t>(header.records.count); }
+		const char* ModelName(uint32_t id) const { return strings + models[id]; }
+		const char* ObjectName(uint32_t id) const { return strings + names[id]; }
+	private:
+		bool Fail() {
+			Close();
+			return false;
+		}
+	};
+}
+#endif
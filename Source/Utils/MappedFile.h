@@ -0,0 +1,138 @@
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+#include <cstddef>
+#include <cstdint>
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+	#include <sys/types.h>
+	#include <sys/stat.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// Read only memory mapping of an entire file.
+// The mapping stays valid until Close() is called or the object is destroyed,
+// so any pointers handed out from Data() must not outlive it.
+class MappedFile
+{
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& that) noexcept { *this = static_cast<MappedFile&&>(that); }
+	MappedFile& operator=(MappedFile&& that) noexcept
+	{
+		if (this != &that) {
+			Close();
+			data = that.data; that.data = nullptr;
+			size = that.size; that.size = 0;
+#if defined(_WIN32)
+			file = that.file; that.file = INVALID_HANDLE_VALUE;
+			mapping = that.mapping; that.mapping = nullptr;
+#endif
+		}
+		return *this;
+	}
+
+	bool Open(const char* path)
+	{
+		Close();
+#if defined(_WIN32)
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize) == FALSE) {
+			Close();
+			return false;
+		}
+		size = static_cast<size_t>(fileSize.QuadPart);
+		if (size == 0) // empty files can't be mapped, but they are still valid
+			return true;
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr) {
+			Close();
+			return false;
+		}
+		data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (data == nullptr) {
+			Close();
+			return false;
+		}
+#else
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			close(fd);
+			return false;
+		}
+		size = static_cast<size_t>(info.st_size);
+		if (size > 0) {
+			void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view == MAP_FAILED) {
+				close(fd);
+				size = 0;
+				return false;
+			}
+			madvise(view, size, MADV_SEQUENTIAL);
+			data = static_cast<const unsigned char*>(view);
+		}
+		close(fd); // the mapping keeps its own reference to the file
+#endif
+		return true;
+	}
+	void Close()
+	{
+#if defined(_WIN32)
+		if (data != nullptr)
+			UnmapViewOfFile(data);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data != nullptr)
+			munmap(const_cast<unsigned char*>(data), size);
+#endif
+		data = nullptr;
+		size = 0;
+	}
+	const unsigned char* Data() const { return data; }
+	size_t Size() const { return size; }
+
+	// size and last write time of a file without opening it, false if missing
+	static bool Stat(const char* path, unsigned long long& outSize, long long& outModified)
+	{
+#if defined(_WIN32)
+		struct _stat64 info;
+		if (_stat64(path, &info) != 0)
+			return false;
+#else
+		struct stat info;
+		if (stat(path, &info) != 0)
+			return false;
+#endif
+		outSize = static_cast<unsigned long long>(info.st_size);
+		outModified = static_cast<long long>(info.st_mtime);
+		return true;
+	}
+};
+#endif
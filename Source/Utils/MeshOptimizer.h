@@ -0,0 +1,906 @@
+#ifndef _MESHOPTIMIZER_H_
+#define _MESHOPTIMIZER_H_
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include "h2bParser.h"
+
+// Import time index/vertex reordering passes.
+// All functions work on one model at a time: indices are relative to the model's
+// first vertex, exactly how they are stored in Level_Data::levelIndices.
+namespace MeshOptimizer {
+
+	// Average Cache Miss Ratio (misses per triangle, 0.5 is the ideal for big meshes)
+	// and Average Transform to Vertex Ratio (misses per used vertex, 1.0 is ideal)
+	// of a FIFO post transform cache like the ones found in most GPUs.
+	struct CACHE_STATS {
+		float acmr, atvr;
+	};
+	inline CACHE_STATS AnalyzeVertexCache(const unsigned* indices, size_t indexCount,
+		size_t vertexCount, unsigned cacheSize = 16)
+	{
+		CACHE_STATS stats = { 0, 0 };
+		if (indexCount < 3 || vertexCount == 0)
+			return stats;
+		// a vertex is in the FIFO if it was (re)loaded within the last cacheSize misses
+		std::vector<size_t> loadedAt(vertexCount, 0);
+		std::vector<char> used(vertexCount, 0);
+		size_t misses = 0, unique = 0;
+		for (size_t i = 0; i < indexCount; ++i) {
+			unsigned v = indices[i];
+			if (v >= vertexCount)
+				continue;
+			if (used[v] == 0) {
+				used[v] = 1;
+				++unique;
+			}
+			if (loadedAt[v] == 0 || misses - (loadedAt[v] - 1) >= cacheSize) {
+				loadedAt[v] = ++misses; // stored +1 so 0 means never loaded
+			}
+		}
+		stats.acmr = static_cast<float>(misses) / (indexCount / 3);
+		stats.atvr = (unique > 0) ? static_cast<float>(misses) / unique : 0.0f;
+		return stats;
+	}
+
+	// True when every index names one of vertexCount vertices. The passes that write through
+	// indices leave data failing this untouched (and assert in debug builds), the loader
+	// rejects such files up front but cached, cooked and hot reloaded data come in here too.
+	inline bool IndicesInRange(const unsigned* indices, size_t indexCount, size_t vertexCount)
+	{
+		for (size_t i = 0; i < indexCount; ++i)
+			if (indices[i] >= vertexCount)
+				return false;
+		return true;
+	}
+
+	// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation" on one contiguous
+	// range of triangles. Triangles never leave the range so draw ranges stay valid.
+	// "scratch" must have vertexCount entries set to -1 and is returned that way.
+	inline void OptimizeVertexCacheRange(unsigned* indices, size_t indexCount,
+		std::vector<int>& scratch)
+	{
+		const int kCacheSize = 32;
+		const size_t triCount = indexCount / 3;
+		if (triCount < 2)
+			return;
+		const bool inRange = IndicesInRange(indices, indexCount, scratch.size());
+		assert(inRange);
+		if (inRange == false)
+			return;
+		// compact the vertices this range touches into local ids
+		std::vector<unsigned> globalIds;
+		std::vector<unsigned> local(indexCount);
+		for (size_t i = 0; i < indexCount; ++i) {
+			int& id = scratch[indices[i]];
+			if (id < 0) {
+				id = static_cast<int>(globalIds.size());
+				globalIds.push_back(indices[i]);
+			}
+			local[i] = static_cast<unsigned>(id);
+		}
+		for (unsigned g : globalIds)
+			scratch[g] = -1;
+		const size_t vertCount = globalIds.size();
+		// vertex -> triangle adjacency (CSR)
+		std::vector<unsigned> valence(vertCount, 0), adjStart(vertCount + 1, 0);
+		for (unsigned v : local)
+			++valence[v];
+		for (size_t v = 0; v < vertCount; ++v)
+			adjStart[v + 1] = adjStart[v] + valence[v];
+		std::vector<unsigned> adjacency(indexCount), fill(adjStart.begin(), adjStart.end() - 1);
+		for (size_t t = 0; t < triCount; ++t)
+			for (int k = 0; k < 3; ++k)
+				adjacency[fill[local[t * 3 + k]]++] = static_cast<unsigned>(t);
+		std::vector<unsigned> remaining(valence); // triangles not yet emitted per vertex
+		std::vector<int> cachePos(vertCount, -1);
+		std::vector<float> vertexScore(vertCount), triScore(triCount);
+		std::vector<char> emitted(triCount, 0);
+		auto scoreVertex = [&](unsigned v) -> float {
+			if (remaining[v] == 0)
+				return -1.0f; // nothing left to draw with this vertex
+			float score = 0.0f;
+			int pos = cachePos[v];
+			if (pos >= 0) {
+				if (pos < 3) // used by the last triangle, fixed score so it isn't favored twice
+					score = 0.75f;
+				else
+					score = std::pow(1.0f - (pos - 3) * (1.0f / (kCacheSize - 3)), 1.5f);
+			}
+			// boost vertices with few triangles left so they don't get stranded
+			return score + 2.0f * std::pow(static_cast<float>(remaining[v]), -0.5f);
+		};
+		for (size_t v = 0; v < vertCount; ++v)
+			vertexScore[v] = scoreVertex(static_cast<unsigned>(v));
+		for (size_t t = 0; t < triCount; ++t)
+			triScore[t] = vertexScore[local[t * 3]] + vertexScore[local[t * 3 + 1]] + vertexScore[local[t * 3 + 2]];
+		std::vector<unsigned> cache, nextCache;
+		cache.reserve(kCacheSize + 3);
+		nextCache.reserve(kCacheSize + 3);
+		std::vector<unsigned> output;
+		output.reserve(indexCount);
+		size_t cursor = 0; // first triangle that may still be un-emitted
+		int best = 0;
+		float bestScore = triScore[0];
+		for (size_t t = 1; t < triCount; ++t)
+			if (triScore[t] > bestScore) {
+				bestScore = triScore[t];
+				best = static_cast<int>(t);
+			}
+		while (best >= 0) {
+			// emit the triangle and retire it from its vertices
+			const unsigned* tri = &local[best * 3];
+			emitted[best] = 1;
+			for (int k = 0; k < 3; ++k) {
+				unsigned v = tri[k];
+				output.push_back(globalIds[v]);
+				unsigned* adj = &adjacency[adjStart[v]];
+				unsigned count = remaining[v];
+				for (unsigned a = 0; a < count; ++a)
+					if (adj[a] == static_cast<unsigned>(best)) {
+						adj[a] = adj[count - 1];
+						break;
+					}
+				--remaining[v];
+			}
+			// LRU update: this triangle's vertices go to the front
+			nextCache.assign(tri, tri + 3);
+			for (unsigned v : cache)
+				if (v != tri[0] && v != tri[1] && v != tri[2])
+					nextCache.push_back(v);
+			for (size_t i = kCacheSize; i < nextCache.size(); ++i)
+				cachePos[nextCache[i]] = -1; // evicted
+			if (nextCache.size() > static_cast<size_t>(kCacheSize))
+				nextCache.resize(kCacheSize);
+			for (size_t i = 0; i < nextCache.size(); ++i)
+				cachePos[nextCache[i]] = static_cast<int>(i);
+			// rescore everything that was or still is in the cache
+			for (unsigned v : cache)
+				if (cachePos[v] < 0)
+					vertexScore[v] = scoreVertex(v);
+			cache.swap(nextCache);
+			for (unsigned v : cache)
+				vertexScore[v] = scoreVertex(v);
+			// next best triangle is (almost always) touching the cache
+			best = -1;
+			bestScore = -1.0f;
+			for (unsigned v : cache) {
+				for (unsigned a = 0; a < remaining[v]; ++a) {
+					unsigned t = adjacency[adjStart[v] + a];
+					const unsigned* other = &local[t * 3];
+					float score = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+					triScore[t] = score;
+					if (score > bestScore) {
+						bestScore = score;
+						best = static_cast<int>(t);
+					}
+				}
+			}
+			if (best < 0) { // cache ran dry, continue with the next unused triangle
+				while (cursor < triCount && emitted[cursor])
+					++cursor;
+				best = (cursor < triCount) ? static_cast<int>(cursor) : -1;
+			}
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Optimizes each range [start, start + count) of "indices" independently.
+	// Pass the union of every mesh and batch boundary so none of them moves.
+	inline void OptimizeVertexCache(unsigned* indices, size_t vertexCount,
+		const std::vector<std::pair<unsigned, unsigned>>& ranges)
+	{
+		std::vector<int> scratch(vertexCount, -1);
+		for (auto& r : ranges)
+			OptimizeVertexCacheRange(indices + r.first, r.second, scratch);
+	}
+
+	// Splits [0, indexCount) at every given draw range boundary so each piece
+	// can be reordered without breaking any mesh or batch.
+	inline std::vector<std::pair<unsigned, unsigned>> SplitDrawRanges(size_t indexCount,
+		const std::vector<H2B::BATCH>& drawRanges)
+	{
+		std::vector<unsigned> cuts = { 0, static_cast<unsigned>(indexCount) };
+		for (auto& d : drawRanges) {
+			cuts.push_back(d.indexOffset);
+			cuts.push_back(d.indexOffset + d.indexCount);
+		}
+		std::sort(cuts.begin(), cuts.end());
+		cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+		std::vector<std::pair<unsigned, unsigned>> ranges;
+		for (size_t i = 1; i < cuts.size(); ++i)
+			if (cuts[i] <= indexCount && cuts[i] > cuts[i - 1])
+				ranges.push_back({ cuts[i - 1], (cuts[i] - cuts[i - 1]) / 3 * 3 });
+		return ranges;
+	}
+
+	// FIFO cache step shared by the overdraw passes, returns the misses of one triangle.
+	// A vertex is cached while fewer than cacheSize misses happened since it was loaded,
+	// bumping "clock" by cacheSize + 1 empties the cache.
+	inline unsigned SimulateTriangle(const unsigned* tri, std::vector<unsigned>& loadedAt,
+		unsigned& clock, unsigned cacheSize)
+	{
+		unsigned misses = 0;
+		for (int k = 0; k < 3; ++k)
+			if (clock - loadedAt[tri[k]] > cacheSize) {
+				loadedAt[tri[k]] = clock++;
+				++misses;
+			}
+		return misses;
+	}
+
+	// Sander, Nehab & Barczak "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+	// Cuts the (already cache optimized) range into clusters wherever the cache restarts anyway,
+	// or where the running ACMR is within "threshold" times the ACMR of the surrounding patch,
+	// then draws the clusters that face away from the mesh center first.
+	// threshold 1.0 keeps the cache efficiency, higher values trade it for less overdraw.
+	inline void OptimizeOverdrawRange(unsigned* indices, size_t indexCount,
+		const H2B::VERTEX* vertices, size_t vertexCount, float threshold, unsigned cacheSize = 16)
+	{
+		const size_t triCount = indexCount / 3;
+		if (triCount < 2)
+			return;
+		std::vector<unsigned> loadedAt(vertexCount, 0);
+		unsigned clock = cacheSize + 1;
+		// hard boundaries: all three vertices missed, most likely a disjoint patch
+		std::vector<size_t> hard;
+		for (size_t t = 0; t < triCount; ++t)
+			if (SimulateTriangle(&indices[t * 3], loadedAt, clock, cacheSize) == 3 || t == 0)
+				hard.push_back(t);
+		// soft boundaries: split patches further while their clusters stay cache friendly
+		std::vector<size_t> clusters;
+		for (size_t h = 0; h < hard.size(); ++h) {
+			size_t start = hard[h], end = (h + 1 < hard.size()) ? hard[h + 1] : triCount;
+			clock += cacheSize + 1;
+			unsigned patchMisses = 0;
+			for (size_t t = start; t < end; ++t)
+				patchMisses += SimulateTriangle(&indices[t * 3], loadedAt, clock, cacheSize);
+			float target = threshold * patchMisses / (end - start);
+			clusters.push_back(start);
+			clock += cacheSize + 1;
+			unsigned misses = 0, faces = 0;
+			for (size_t t = start; t < end; ++t) {
+				misses += SimulateTriangle(&indices[t * 3], loadedAt, clock, cacheSize);
+				++faces;
+				if (static_cast<float>(misses) / faces <= target) {
+					clusters.push_back(t + 1);
+					clock += cacheSize + 1;
+					misses = faces = 0;
+				}
+			}
+			// the cut after the last triangle is the next patch, a leftover tail
+			// that never reached the target is merged into the cluster before it
+			if (clusters.back() == end || (faces > 0 && clusters.back() != start))
+				clusters.pop_back();
+		}
+		// area weighted centroid of the whole range
+		auto corner = [&](size_t t, int k) -> const H2B::VECTOR& { return vertices[indices[t * 3 + k]].pos; };
+		float cx = 0, cy = 0, cz = 0, totalArea = 0;
+		std::vector<float> triArea(triCount), nx(triCount), ny(triCount), nz(triCount);
+		for (size_t t = 0; t < triCount; ++t) {
+			const H2B::VECTOR& a = corner(t, 0), & b = corner(t, 1), & c = corner(t, 2);
+			float ex = b.x - a.x, ey = b.y - a.y, ez = b.z - a.z;
+			float fx = c.x - a.x, fy = c.y - a.y, fz = c.z - a.z;
+			nx[t] = ey * fz - ez * fy; // twice the area along the face normal
+			ny[t] = ez * fx - ex * fz;
+			nz[t] = ex * fy - ey * fx;
+			triArea[t] = std::sqrt(nx[t] * nx[t] + ny[t] * ny[t] + nz[t] * nz[t]);
+			cx += (a.x + b.x + c.x) * triArea[t];
+			cy += (a.y + b.y + c.y) * triArea[t];
+			cz += (a.z + b.z + c.z) * triArea[t];
+			totalArea += triArea[t] * 3.0f;
+		}
+		if (totalArea <= 0.0f)
+			return;
+		cx /= totalArea; cy /= totalArea; cz /= totalArea;
+		// occlusion potential: how far the cluster sits out along its own average normal
+		std::vector<std::pair<float, size_t>> order(clusters.size());
+		for (size_t c = 0; c < clusters.size(); ++c) {
+			size_t start = clusters[c], end = (c + 1 < clusters.size()) ? clusters[c + 1] : triCount;
+			float px = 0, py = 0, pz = 0, area = 0, sx = 0, sy = 0, sz = 0;
+			for (size_t t = start; t < end; ++t) {
+				const H2B::VECTOR& a = corner(t, 0), & b = corner(t, 1), & d = corner(t, 2);
+				px += (a.x + b.x + d.x) * triArea[t];
+				py += (a.y + b.y + d.y) * triArea[t];
+				pz += (a.z + b.z + d.z) * triArea[t];
+				area += triArea[t] * 3.0f;
+				sx += nx[t]; sy += ny[t]; sz += nz[t];
+			}
+			float key = 0.0f;
+			float len = std::sqrt(sx * sx + sy * sy + sz * sz);
+			if (area > 0.0f && len > 0.0f)
+				key = ((px / area - cx) * sx + (py / area - cy) * sy + (pz / area - cz) * sz) / len;
+			order[c] = { key, c };
+		}
+		std::stable_sort(order.begin(), order.end(),
+			[](const std::pair<float, size_t>& l, const std::pair<float, size_t>& r) { return l.first > r.first; });
+		std::vector<unsigned> output;
+		output.reserve(triCount * 3);
+		for (auto& o : order) {
+			size_t start = clusters[o.second], end = (o.second + 1 < clusters.size()) ? clusters[o.second + 1] : triCount;
+			output.insert(output.end(), indices + start * 3, indices + end * 3);
+		}
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	// Offline overdraw estimate: rasterizes the triangles in index order from "viewCount"
+	// directions spread over a sphere (orthographic, depth tested, D3D default back face culling)
+	// and counts how many pixels were shaded for every pixel the mesh finally covers.
+	struct OVERDRAW_STATS {
+		unsigned long long pixelsShaded, pixelsCovered;
+		float overdraw; // shaded / covered, 1.0 is perfect
+	};
+	inline OVERDRAW_STATS EstimateOverdraw(const H2B::VERTEX* vertices, size_t vertexCount,
+		const unsigned* indices, size_t indexCount, unsigned viewCount = 16, unsigned resolution = 256)
+	{
+		OVERDRAW_STATS stats = { 0, 0, 0.0f };
+		if (vertexCount == 0 || indexCount < 3)
+			return stats;
+		float lo[3] = { vertices[0].pos.x, vertices[0].pos.y, vertices[0].pos.z };
+		float hi[3] = { lo[0], lo[1], lo[2] };
+		for (size_t v = 1; v < vertexCount; ++v) {
+			const float* p = &vertices[v].pos.x;
+			for (int k = 0; k < 3; ++k) {
+				lo[k] = std::min(lo[k], p[k]);
+				hi[k] = std::max(hi[k], p[k]);
+			}
+		}
+		float center[3] = { (lo[0] + hi[0]) * 0.5f, (lo[1] + hi[1]) * 0.5f, (lo[2] + hi[2]) * 0.5f };
+		float radius = 0.5f * std::sqrt((hi[0] - lo[0]) * (hi[0] - lo[0]) +
+			(hi[1] - lo[1]) * (hi[1] - lo[1]) + (hi[2] - lo[2]) * (hi[2] - lo[2]));
+		if (radius <= 0.0f)
+			return stats;
+		const float size = static_cast<float>(resolution);
+		std::vector<float> depth(resolution * resolution);
+		std::vector<float> sx(vertexCount), sy(vertexCount), sz(vertexCount);
+		for (unsigned view = 0; view < viewCount; ++view) {
+			// fibonacci sphere direction, then a left handed look-at basis like the renderer's
+			float y = 1.0f - 2.0f * (view + 0.5f) / viewCount;
+			float ring = std::sqrt(std::max(0.0f, 1.0f - y * y));
+			float angle = view * 2.39996323f;
+			float fwd[3] = { std::cos(angle) * ring, y, std::sin(angle) * ring };
+			float up0[3] = { 0.0f, 1.0f, 0.0f };
+			if (std::fabs(fwd[1]) > 0.99f) {
+				up0[1] = 0.0f;
+				up0[2] = 1.0f;
+			}
+			float right[3] = { up0[1] * fwd[2] - up0[2] * fwd[1], up0[2] * fwd[0] - up0[0] * fwd[2], up0[0] * fwd[1] - up0[1] * fwd[0] };
+			float rlen = std::sqrt(right[0] * right[0] + right[1] * right[1] + right[2] * right[2]);
+			for (int k = 0; k < 3; ++k)
+				right[k] /= rlen;
+			float up[3] = { fwd[1] * right[2] - fwd[2] * right[1], fwd[2] * right[0] - fwd[0] * right[2], fwd[0] * right[1] - fwd[1] * right[0] };
+			for (size_t v = 0; v < vertexCount; ++v) {
+				float d[3] = { vertices[v].pos.x - center[0], vertices[v].pos.y - center[1], vertices[v].pos.z - center[2] };
+				sx[v] = ((d[0] * right[0] + d[1] * right[1] + d[2] * right[2]) / radius * 0.5f + 0.5f) * size;
+				sy[v] = ((d[0] * up[0] + d[1] * up[1] + d[2] * up[2]) / radius * 0.5f + 0.5f) * size;
+				sz[v] = d[0] * fwd[0] + d[1] * fwd[1] + d[2] * fwd[2];
+			}
+			std::fill(depth.begin(), depth.end(), 3.402823466e+38f);
+			for (size_t i = 0; i + 2 < indexCount; i += 3) {
+				unsigned a = indices[i], b = indices[i + 1], c = indices[i + 2];
+				float area = (sx[b] - sx[a]) * (sy[c] - sy[a]) - (sy[b] - sy[a]) * (sx[c] - sx[a]);
+				if (area >= 0.0f) // counter clockwise with y up is a back face (or degenerate)
+					continue;
+				int x0 = std::max(0, static_cast<int>(std::floor(std::min(sx[a], std::min(sx[b], sx[c])))));
+				int x1 = std::min(static_cast<int>(resolution) - 1, static_cast<int>(std::ceil(std::max(sx[a], std::max(sx[b], sx[c])))));
+				int y0 = std::max(0, static_cast<int>(std::floor(std::min(sy[a], std::min(sy[b], sy[c])))));
+				int y1 = std::min(static_cast<int>(resolution) - 1, static_cast<int>(std::ceil(std::max(sy[a], std::max(sy[b], sy[c])))));
+				for (int py = y0; py <= y1; ++py)
+					for (int px = x0; px <= x1; ++px) {
+						float fx = px + 0.5f, fy = py + 0.5f;
+						// barycentrics of the pixel center, all <= 0 inside a clockwise triangle
+						float wa = (sx[c] - sx[b]) * (fy - sy[b]) - (sy[c] - sy[b]) * (fx - sx[b]);
+						float wb = (sx[a] - sx[c]) * (fy - sy[c]) - (sy[a] - sy[c]) * (fx - sx[c]);
+						float wc = (sx[b] - sx[a]) * (fy - sy[a]) - (sy[b] - sy[a]) * (fx - sx[a]);
+						if (wa > 0.0f || wb > 0.0f || wc > 0.0f)
+							continue;
+						float z = (wa * sz[a] + wb * sz[b] + wc * sz[c]) / area;
+						float& stored = depth[py * resolution + px];
+						if (z < stored) {
+							if (stored == 3.402823466e+38f)
+								++stats.pixelsCovered;
+							stored = z;
+							++stats.pixelsShaded;
+						}
+					}
+			}
+		}
+		stats.overdraw = (stats.pixelsCovered > 0) ?
+			static_cast<float>(stats.pixelsShaded) / stats.pixelsCovered : 0.0f;
+		return stats;
+	}
+
+	// Collapses duplicate vertices of one model and remaps its indices.
+	// epsilon 0 only merges bit identical vertices, otherwise every component
+	// (position, uvw and normal) may differ by up to epsilon. Vertices no index uses are dropped.
+	// Survivors are compacted to the front of "vertices" in their original order,
+	// the return value is how many there are.
+	inline size_t WeldVertices(H2B::VERTEX* vertices, size_t vertexCount,
+		unsigned* indices, size_t indexCount, float epsilon)
+	{
+		const bool inRange = IndicesInRange(indices, indexCount, vertexCount);
+		assert(inRange);
+		if (inRange == false)
+			return vertexCount; // nothing welded
+		std::vector<unsigned> remap(vertexCount, ~0u);
+		std::vector<char> used(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; ++i)
+			used[indices[i]] = 1;
+		unsigned kept = 0;
+		if (epsilon <= 0.0f) {
+			// the set holds kept slots, lookups use the source slot which is never behind them
+			auto hash = [vertices](unsigned v) {
+				unsigned long long h = 14695981039346656037ull;
+				const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertices[v]);
+				for (size_t b = 0; b < sizeof(H2B::VERTEX); ++b)
+					h = (h ^ bytes[b]) * 1099511628211ull;
+				return static_cast<size_t>(h);
+			};
+			auto equal = [vertices](unsigned a, unsigned b) {
+				return std::memcmp(&vertices[a], &vertices[b], sizeof(H2B::VERTEX)) == 0;
+			};
+			std::unordered_set<unsigned, decltype(hash), decltype(equal)> unique(vertexCount, hash, equal);
+			for (size_t v = 0; v < vertexCount; ++v) {
+				if (used[v] == 0)
+					continue;
+				auto found = unique.find(static_cast<unsigned>(v));
+				if (found != unique.end()) {
+					remap[v] = *found;
+					continue;
+				}
+				vertices[kept] = vertices[v];
+				remap[v] = kept;
+				unique.insert(kept++);
+			}
+		}
+		else {
+			// grid of epsilon sized cells over the positions, a match can only be in a neighbor cell
+			auto cellOf = [epsilon](float f) { return static_cast<long long>(std::floor(f / epsilon)); };
+			auto cellKey = [](long long x, long long y, long long z) {
+				return static_cast<unsigned long long>(x) * 73856093ull ^
+					static_cast<unsigned long long>(y) * 19349663ull ^ static_cast<unsigned long long>(z) * 83492791ull;
+			};
+			auto near = [epsilon](const H2B::VERTEX& a, const H2B::VERTEX& b) {
+				const float* fa = &a.pos.x;
+				const float* fb = &b.pos.x;
+				for (size_t k = 0; k < sizeof(H2B::VERTEX) / sizeof(float); ++k)
+					if (std::fabs(fa[k] - fb[k]) > epsilon)
+						return false;
+				return true;
+			};
+			std::unordered_map<unsigned long long, std::vector<unsigned>> grid;
+			for (size_t v = 0; v < vertexCount; ++v) {
+				if (used[v] == 0)
+					continue;
+				const H2B::VERTEX& vertex = vertices[v];
+				long long cx = cellOf(vertex.pos.x), cy = cellOf(vertex.pos.y), cz = cellOf(vertex.pos.z);
+				for (long long dz = -1; dz <= 1 && remap[v] == ~0u; ++dz)
+					for (long long dy = -1; dy <= 1 && remap[v] == ~0u; ++dy)
+						for (long long dx = -1; dx <= 1 && remap[v] == ~0u; ++dx) {
+							auto cell = grid.find(cellKey(cx + dx, cy + dy, cz + dz));
+							if (cell == grid.end())
+								continue;
+							for (unsigned candidate : cell->second)
+								if (near(vertices[candidate], vertex)) {
+									remap[v] = candidate;
+									break;
+								}
+						}
+				if (remap[v] != ~0u)
+					continue;
+				vertices[kept] = vertex;
+				remap[v] = kept;
+				grid[cellKey(cx, cy, cz)].push_back(kept++);
+			}
+		}
+		for (size_t i = 0; i < indexCount; ++i)
+			indices[i] = remap[indices[i]];
+		return kept;
+	}
+
+	// A run of consecutive triangles small enough to be culled as one unit.
+	// Meshlets never reorder indices, they only split an existing draw range,
+	// so a visible run of them is still one DrawIndexed call.
+	struct MESHLET {
+		H2B::VECTOR center; float radius; // bounding sphere
+		H2B::VECTOR coneApex; float coneCutoff; // cutoff above 1 means the cone can't cull
+		H2B::VECTOR coneAxis; unsigned vertexCount;
+		unsigned indexOffset, triangleCount; // relative to the model, like MESH::drawInfo
+	};
+	// Every triangle faces away from "eye" (same space as the meshlet)
+	// when it looks down the cone from outside of it.
+	inline bool ConeBackfacing(const MESHLET& m, float eyeX, float eyeY, float eyeZ)
+	{
+		float dx = m.coneApex.x - eyeX, dy = m.coneApex.y - eyeY, dz = m.coneApex.z - eyeZ;
+		float len = std::sqrt(dx * dx + dy * dy + dz * dz);
+		return dx * m.coneAxis.x + dy * m.coneAxis.y + dz * m.coneAxis.z >= m.coneCutoff * len;
+	}
+	inline void ComputeMeshletBounds(const H2B::VERTEX* vertices, const unsigned* indices, MESHLET& m)
+	{
+		const unsigned* tris = indices + m.indexOffset;
+		const size_t count = m.triangleCount * 3;
+		// Ritter's sphere: start from the farthest pair along one sweep, then grow
+		auto pos = [&](size_t i) -> const H2B::VECTOR& { return vertices[tris[i]].pos; };
+		auto dist2 = [](const H2B::VECTOR& a, const H2B::VECTOR& b) {
+			return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z);
+		};
+		size_t far0 = 0, far1 = 0;
+		for (size_t i = 1; i < count; ++i)
+			if (dist2(pos(i), pos(0)) > dist2(pos(far0), pos(0)))
+				far0 = i;
+		for (size_t i = 0; i < count; ++i)
+			if (dist2(pos(i), pos(far0)) > dist2(pos(far1), pos(far0)))
+				far1 = i;
+		const H2B::VECTOR& a = pos(far0), & b = pos(far1);
+		H2B::VECTOR c = { (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f };
+		float r = std::sqrt(dist2(a, b)) * 0.5f;
+		for (size_t i = 0; i < count; ++i) {
+			float d = std::sqrt(dist2(pos(i), c));
+			if (d > r) { // move the center half way towards the outlier
+				float grow = (d - r) * 0.5f / d;
+				c.x += (pos(i).x - c.x) * grow;
+				c.y += (pos(i).y - c.y) * grow;
+				c.z += (pos(i).z - c.z) * grow;
+				r = (r + d) * 0.5f;
+			}
+		}
+		m.center = c;
+		m.radius = r;
+		// normal cone around the average face normal (D3D front faces: clockwise)
+		std::vector<H2B::VECTOR> normals;
+		normals.reserve(m.triangleCount);
+		H2B::VECTOR axis = { 0, 0, 0 };
+		for (size_t t = 0; t < m.triangleCount; ++t) {
+			const H2B::VECTOR& p0 = pos(t * 3), & p1 = pos(t * 3 + 1), & p2 = pos(t * 3 + 2);
+			float ex = p1.x - p0.x, ey = p1.y - p0.y, ez = p1.z - p0.z;
+			float fx = p2.x - p0.x, fy = p2.y - p0.y, fz = p2.z - p0.z;
+			H2B::VECTOR n = { ey * fz - ez * fy, ez * fx - ex * fz, ex * fy - ey * fx };
+			float len = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+			n = (len > 0.0f) ? H2B::VECTOR{ n.x / len, n.y / len, n.z / len } : H2B::VECTOR{ 0, 0, 0 };
+			normals.push_back(n); // degenerate triangles stay zero, they are never visible
+			axis = { axis.x + n.x, axis.y + n.y, axis.z + n.z };
+		}
+		float axisLen = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+		m.coneApex = c;
+		m.coneAxis = { 0, 0, 0 };
+		m.coneCutoff = 2.0f;
+		if (axisLen <= 0.0f)
+			return;
+		axis = { axis.x / axisLen, axis.y / axisLen, axis.z / axisLen };
+		float minDot = 1.0f;
+		for (auto& n : normals)
+			if (n.x != 0.0f || n.y != 0.0f || n.z != 0.0f)
+				minDot = std::min(minDot, n.x * axis.x + n.y * axis.y + n.z * axis.z);
+		if (minDot <= 0.1f) // spread over (nearly) a hemisphere, the cone can't cull anything
+			return;
+		// slide the apex back until every triangle plane is in front of it
+		float maxT = 0.0f;
+		for (size_t t = 0; t < m.triangleCount; ++t) {
+			const H2B::VECTOR& p0 = pos(t * 3), & n = normals[t];
+			if (n.x == 0.0f && n.y == 0.0f && n.z == 0.0f)
+				continue;
+			float dc = (c.x - p0.x) * n.x + (c.y - p0.y) * n.y + (c.z - p0.z) * n.z;
+			float dn = axis.x * n.x + axis.y * n.y + axis.z * n.z;
+			maxT = std::max(maxT, dc / dn);
+		}
+		m.coneApex = { c.x - axis.x * maxT, c.y - axis.y * maxT, c.z - axis.z * maxT };
+		m.coneAxis = axis;
+		m.coneCutoff = std::sqrt(1.0f - minDot * minDot); // sine of the cone's half angle
+	}
+	// Cuts [indexOffset, indexOffset + indexCount) into meshlets in draw order.
+	// Works best on cache optimized ranges since those already walk the surface.
+	// "scratch" must have vertexCount entries set to ~0u and is returned that way.
+	inline void BuildMeshlets(const H2B::VERTEX* vertices, const unsigned* indices,
+		unsigned indexOffset, unsigned indexCount, std::vector<unsigned>& scratch,
+		std::vector<MESHLET>& out, unsigned maxVertices = 64, unsigned maxTriangles = 124)
+	{
+		MESHLET current = {};
+		current.indexOffset = indexOffset;
+		std::vector<unsigned> touched; // vertices of the current meshlet, to reset scratch
+		auto finish = [&]() {
+			if (current.triangleCount == 0)
+				return;
+			current.vertexCount = static_cast<unsigned>(touched.size());
+			ComputeMeshletBounds(vertices, indices, current);
+			out.push_back(current);
+			for (unsigned v : touched)
+				scratch[v] = ~0u;
+			touched.clear();
+			current.indexOffset += current.triangleCount * 3;
+			current.triangleCount = 0;
+		};
+		const unsigned* tris = indices + indexOffset;
+		for (unsigned t = 0; t < indexCount / 3; ++t) {
+			unsigned added = 0;
+			for (int k = 0; k < 3; ++k)
+				if (scratch[tris[t * 3 + k]] == ~0u &&
+					(k == 0 || tris[t * 3 + k] != tris[t * 3]) && (k < 2 || tris[t * 3 + 2] != tris[t * 3 + 1]))
+					++added;
+			if (touched.size() + added > maxVertices || current.triangleCount == maxTriangles)
+				finish();
+			for (int k = 0; k < 3; ++k) {
+				unsigned& slot = scratch[tris[t * 3 + k]];
+				if (slot == ~0u) {
+					slot = static_cast<unsigned>(touched.size());
+					touched.push_back(tris[t * 3 + k]);
+				}
+			}
+			++current.triangleCount;
+		}
+		finish();
+	}
+
+	// One level of detail of a mesh, offsets relative to the model like MESH::drawInfo
+	struct MESH_LOD {
+		unsigned indexCount, indexOffset;
+		float error; // largest distance (model units) a moved vertex ended up from its original planes, 0 for the original
+	};
+
+	// Symmetric 4x4 error quadric (Garland & Heckbert), squared distance to a set of planes
+	struct QUADRIC {
+		double a00, a01, a02, a11, a12, a22, b0, b1, b2, c;
+		void AddPlane(double nx, double ny, double nz, double d) {
+			a00 += nx * nx; a01 += nx * ny; a02 += nx * nz;
+			a11 += ny * ny; a12 += ny * nz; a22 += nz * nz;
+			b0 += nx * d; b1 += ny * d; b2 += nz * d; c += d * d;
+		}
+		void Add(const QUADRIC& q) {
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+		}
+		double Evaluate(const H2B::VECTOR& p) const {
+			double x = p.x, y = p.y, z = p.z;
+			double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+				2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return e > 0.0 ? e : 0.0;
+		}
+	};
+
+	// Edge collapse simplification of one mesh range towards targetIndexCount.
+	// Collapses only move a vertex onto a neighbor so the result reuses the model's vertices.
+	// Vertices are grouped by position first: a position with more than one uv (a seam),
+	// or on an edge used by one triangle (holes and material borders, every mesh is
+	// simplified on its own), never moves. Returns the new triangle list, outError is the
+	// farthest any moved vertex ended up from the original triangle planes around it.
+	inline std::vector<unsigned> SimplifyMesh(const H2B::VERTEX* vertices, size_t vertexCount,
+		const unsigned* indices, size_t indexCount, size_t targetIndexCount, float& outError)
+	{
+		outError = 0.0f;
+		// position groups and the vertices ("wedges") that share each one
+		std::vector<unsigned> groupOf(vertexCount, ~0u);
+		std::vector<std::vector<unsigned>> wedges;
+		std::unordered_map<unsigned long long, std::vector<unsigned>> byPosition;
+		for (size_t i = 0; i < indexCount; ++i) {
+			unsigned v = indices[i];
+			if (groupOf[v] != ~0u)
+				continue;
+			const H2B::VECTOR& p = vertices[v].pos;
+			unsigned long long key = 14695981039346656037ull;
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&p);
+			for (size_t b = 0; b < sizeof(p); ++b)
+				key = (key ^ bytes[b]) * 1099511628211ull;
+			for (unsigned g : byPosition[key])
+				if (std::memcmp(&vertices[wedges[g][0]].pos, &p, sizeof(p)) == 0) {
+					groupOf[v] = g;
+					break;
+				}
+			if (groupOf[v] == ~0u) {
+				groupOf[v] = static_cast<unsigned>(wedges.size());
+				byPosition[key].push_back(groupOf[v]);
+				wedges.emplace_back();
+			}
+			wedges[groupOf[v]].push_back(v);
+		}
+		const size_t groupCount = wedges.size();
+		auto position = [&](unsigned g) -> const H2B::VECTOR& { return vertices[wedges[g][0]].pos; };
+		std::vector<char> locked(groupCount, 0);
+		for (size_t g = 0; g < groupCount; ++g)
+			for (unsigned w : wedges[g])
+				if (std::fabs(vertices[w].uvw.x - vertices[wedges[g][0]].uvw.x) > 1e-6f ||
+					std::fabs(vertices[w].uvw.y - vertices[wedges[g][0]].uvw.y) > 1e-6f)
+					locked[g] = 1;
+		// triangles in group space, plus borders and plane quadrics
+		std::vector<unsigned> tris;
+		tris.reserve(indexCount);
+		for (size_t i = 0; i + 2 < indexCount; i += 3) {
+			unsigned a = groupOf[indices[i]], b = groupOf[indices[i + 1]], c = groupOf[indices[i + 2]];
+			if (a != b && b != c && a != c) {
+				tris.push_back(a); tris.push_back(b); tris.push_back(c);
+			}
+		}
+		std::unordered_map<unsigned long long, unsigned> edgeUse;
+		auto edgeKey = [](unsigned a, unsigned b) {
+			return (static_cast<unsigned long long>(std::min(a, b)) << 32) | std::max(a, b);
+		};
+		std::vector<QUADRIC> quadrics(groupCount, QUADRIC{});
+		// original triangle planes around each group, collapses measure how far they move from them
+		std::vector<double> planes;
+		std::vector<std::vector<unsigned>> planesOf(groupCount);
+		for (size_t t = 0; t < tris.size(); t += 3) {
+			for (int k = 0; k < 3; ++k)
+				++edgeUse[edgeKey(tris[t + k], tris[t + (k + 1) % 3])];
+			const H2B::VECTOR& p0 = position(tris[t]), & p1 = position(tris[t + 1]), & p2 = position(tris[t + 2]);
+			double ex = p1.x - p0.x, ey = p1.y - p0.y, ez = p1.z - p0.z;
+			double fx = p2.x - p0.x, fy = p2.y - p0.y, fz = p2.z - p0.z;
+			double nx = ey * fz - ez * fy, ny = ez * fx - ex * fz, nz = ex * fy - ey * fx;
+			double len = std::sqrt(nx * nx + ny * ny + nz * nz);
+			if (len <= 0.0)
+				continue;
+			nx /= len; ny /= len; nz /= len;
+			const double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+			for (int k = 0; k < 3; ++k) {
+				quadrics[tris[t + k]].AddPlane(nx, ny, nz, d);
+				planesOf[tris[t + k]].push_back(static_cast<unsigned>(planes.size() / 4));
+			}
+			planes.insert(planes.end(), { nx, ny, nz, d });
+		}
+		for (auto& e : edgeUse)
+			if (e.second != 2) { // border or non manifold
+				locked[e.first >> 32] = 1;
+				locked[e.first & 0xFFFFFFFFu] = 1;
+			}
+		// greedy passes: cheapest independent collapses first, then rebuild and repeat
+		std::vector<unsigned> collapsedTo(groupCount);
+		for (size_t g = 0; g < groupCount; ++g)
+			collapsedTo[g] = static_cast<unsigned>(g);
+		std::vector<char> touched(groupCount);
+		std::vector<unsigned> adjStart(groupCount + 1), adjacency;
+		struct COLLAPSE { double cost; unsigned from, to; };
+		std::vector<COLLAPSE> candidates;
+		double worst = 0.0;
+		while (tris.size() > targetIndexCount) {
+			// vertex -> triangle adjacency of the current triangles
+			std::fill(adjStart.begin(), adjStart.end(), 0);
+			for (unsigned g : tris)
+				++adjStart[g + 1];
+			for (size_t g = 0; g < groupCount; ++g)
+				adjStart[g + 1] += adjStart[g];
+			adjacency.resize(tris.size());
+			std::vector<unsigned> fill(adjStart.begin(), adjStart.end() - 1);
+			for (size_t i = 0; i < tris.size(); ++i)
+				adjacency[fill[tris[i]]++] = static_cast<unsigned>(i / 3);
+			candidates.clear();
+			for (size_t t = 0; t < tris.size(); t += 3)
+				for (int k = 0; k < 3; ++k) {
+					unsigned a = tris[t + k], b = tris[t + (k + 1) % 3];
+					// each edge is seen from both of its triangles, so one direction per visit covers both
+					if (locked[a] == 0) {
+						QUADRIC q = quadrics[a];
+						q.Add(quadrics[b]);
+						candidates.push_back({ q.Evaluate(position(b)), a, b });
+					}
+				}
+			std::sort(candidates.begin(), candidates.end(),
+				[](const COLLAPSE& l, const COLLAPSE& r) { return l.cost < r.cost; });
+			std::fill(touched.begin(), touched.end(), 0);
+			size_t remaining = tris.size(), collapses = 0;
+			for (const COLLAPSE& c : candidates) {
+				if (remaining <= targetIndexCount)
+					break;
+				if (touched[c.from] || touched[c.to])
+					continue;
+				// reject collapses that would flip a triangle around "from"
+				bool flips = false;
+				size_t removed = 0;
+				const H2B::VECTOR& target = position(c.to);
+				for (unsigned a = adjStart[c.from]; a < adjStart[c.from + 1] && flips == false; ++a) {
+					const unsigned* tri = &tris[adjacency[a] * 3];
+					if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+						++removed;
+						continue;
+					}
+					const H2B::VECTOR* p[3] = { &position(tri[0]), &position(tri[1]), &position(tri[2]) };
+					H2B::VECTOR moved[3] = { *p[0], *p[1], *p[2] };
+					for (int k = 0; k < 3; ++k)
+						if (tri[k] == c.from)
+							moved[k] = target;
+					auto normal = [](const H2B::VECTOR& p0, const H2B::VECTOR& p1, const H2B::VECTOR& p2) {
+						float ex = p1.x - p0.x, ey = p1.y - p0.y, ez = p1.z - p0.z;
+						float fx = p2.x - p0.x, fy = p2.y - p0.y, fz = p2.z - p0.z;
+						return H2B::VECTOR{ ey * fz - ez * fy, ez * fx - ex * fz, ex * fy - ey * fx };
+					};
+					H2B::VECTOR before = normal(*p[0], *p[1], *p[2]), after = normal(moved[0], moved[1], moved[2]);
+					flips = before.x * after.x + before.y * after.y + before.z * after.z <= 0.0f;
+				}
+				if (flips)
+					continue;
+				collapsedTo[c.from] = c.to;
+				quadrics[c.to].Add(quadrics[c.from]);
+				// the quadric cost sums squares over every merged plane, the error is the farthest single one
+				for (unsigned plane : planesOf[c.from]) {
+					const double* n = &planes[plane * 4];
+					worst = std::max(worst, std::fabs(n[0] * target.x + n[1] * target.y + n[2] * target.z + n[3]));
+				}
+				std::vector<unsigned>& into = planesOf[c.to];
+				into.insert(into.end(), planesOf[c.from].begin(), planesOf[c.from].end());
+				std::vector<unsigned>().swap(planesOf[c.from]);
+				// everything around "from" changed shape, leave it alone until the next pass
+				for (unsigned a = adjStart[c.from]; a < adjStart[c.from + 1]; ++a)
+					for (int k = 0; k < 3; ++k)
+						touched[tris[adjacency[a] * 3 + k]] = 1;
+				remaining -= removed * 3;
+				++collapses;
+			}
+			if (collapses == 0)
+				break; // nothing left that can move
+			size_t kept = 0;
+			for (size_t t = 0; t < tris.size(); t += 3) {
+				unsigned a = collapsedTo[tris[t]], b = collapsedTo[tris[t + 1]], c = collapsedTo[tris[t + 2]];
+				if (a == b || b == c || a == c)
+					continue;
+				tris[kept++] = a; tris[kept++] = b; tris[kept++] = c;
+			}
+			tris.resize(kept);
+		}
+		outError = static_cast<float>(worst);
+		// back to real vertices: corners that didn't move keep theirs, moved ones take the
+		// wedge of their new position with the closest uv & normal
+		std::vector<unsigned> output;
+		output.reserve(tris.size());
+		auto finalGroup = [&](unsigned g) {
+			while (collapsedTo[g] != g)
+				g = collapsedTo[g];
+			return g;
+		};
+		for (size_t i = 0; i + 2 < indexCount; i += 3) {
+			unsigned corner[3], g[3];
+			for (int k = 0; k < 3; ++k) {
+				corner[k] = indices[i + k];
+				g[k] = finalGroup(groupOf[corner[k]]);
+			}
+			if (g[0] == g[1] || g[1] == g[2] || g[0] == g[2])
+				continue;
+			for (int k = 0; k < 3; ++k) {
+				unsigned v = corner[k];
+				if (g[k] != groupOf[v]) {
+					const H2B::VERTEX& from = vertices[v];
+					float best = 3.402823466e+38f;
+					for (unsigned w : wedges[g[k]]) {
+						const H2B::VERTEX& to = vertices[w];
+						float du = to.uvw.x - from.uvw.x, dv = to.uvw.y - from.uvw.y;
+						float dn = to.nrm.x * from.nrm.x + to.nrm.y * from.nrm.y + to.nrm.z * from.nrm.z;
+						float score = (du * du + dv * dv) * 100.0f - dn;
+						if (score < best) {
+							best = score;
+							v = w;
+						}
+					}
+				}
+				output.push_back(v);
+			}
+		}
+		return output;
+	}
+
+	// Renumbers vertices in the order the indices first reference them, so the
+	// vertex fetch walks memory forward. Unreferenced vertices keep their relative
+	// order at the end, the vertex count never changes.
+	inline void OptimizeVertexFetch(H2B::VERTEX* vertices, size_t vertexCount,
+		unsigned* indices, size_t indexCount)
+	{
+		const bool inRange = IndicesInRange(indices, indexCount, vertexCount);
+		assert(inRange);
+		if (inRange == false)
+			return;
+		std::vector<unsigned> remap(vertexCount, ~0u);
+		unsigned next = 0;
+		for (size_t i = 0; i < indexCount; ++i) {
+			unsigned& r = remap[indices[i]];
+			if (r == ~0u)
+				r = next++;
+			indices[i] = r;
+		}
+		for (size_t v = 0; v < vertexCount; ++v)
+			if (remap[v] == ~0u)
+				remap[v] = next++;
+		std::vector<H2B::VERTEX> reordered(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+			reordered[remap[v]] = vertices[v];
+		std::copy(reordered.begin(), reordered.end(), vertices);
+	}
+}
+#endif
@@ -0,0 +1,165 @@
+#ifndef _MODELCACHE_H_
+#define _MODELCACHE_H_
+#include "h2bParser.h"
+#include "VirtualFile.h"
+#include "MeshOptimizer.h"
+#include "Bounds.h"
+#include "VertexPacking.h"
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Keeps fully imported & processed models resident between level loads so
+// switching levels only reads the .h2b files it hasn't seen yet.
+// Entries are keyed by path and only trusted while the file's size, modification
+// time and the import settings still match. Once the resident size goes over
+// the budget the least recently used models are dropped, a level still holding
+// one keeps it alive through its shared_ptr. Safe to share between threads.
+class ModelCache
+{
+public:
+	struct MODEL_DATA // one model as it appears in the level arrays, every start rebased to 0
+	{
+		std::vector<char> strings; // names, material & mesh strings hold 1 based offsets into it (0 = nullptr)
+		std::vector<H2B::VERTEX> vertices;
+		std::vector<VertexPacking::PACKED_VERTEX> packedVertices; // empty unless packVertices was on
+		std::vector<unsigned> indices; // including any LOD ranges
+		std::vector<unsigned char> indexBuffer; // narrowed indices, 4 byte padded, empty unless narrowIndices was on
+		std::vector<H2B::MATERIAL> materials;
+		std::vector<H2B::BATCH> batches;
+		std::vector<H2B::MESH> meshes;
+		std::vector<MeshOptimizer::MESHLET> meshlets;
+		std::vector<unsigned> meshletCounts; // per mesh, empty unless buildMeshlets was on
+		std::vector<MeshOptimizer::MESH_LOD> meshLods;
+		std::vector<unsigned> lodCounts; // per mesh, empty unless generateLods was on
+		std::vector<Bounds::VOLUME> meshBounds; // per mesh, model space
+		Bounds::VOLUME modelBounds;
+		VertexPacking::BOUNDS vertexBounds;
+		unsigned indexFormat;
+
+		size_t Bytes() const {
+			return sizeof(MODEL_DATA) + strings.size() +
+				vertices.size() * sizeof(H2B::VERTEX) +
+				packedVertices.size() * sizeof(VertexPacking::PACKED_VERTEX) +
+				indices.size() * sizeof(unsigned) + indexBuffer.size() +
+				materials.size() * sizeof(H2B::MATERIAL) + batches.size() * sizeof(H2B::BATCH) +
+				meshes.size() * sizeof(H2B::MESH) + meshlets.size() * sizeof(MeshOptimizer::MESHLET) +
+				meshletCounts.size() * sizeof(unsigned) + meshLods.size() * sizeof(MeshOptimizer::MESH_LOD) +
+				lodCounts.size() * sizeof(unsigned) + meshBounds.size() * sizeof(Bounds::VOLUME);
+		}
+		// stores a copy of "str" and returns the value to keep in its place
+		const char* AddString(const char* str) {
+			if (str == nullptr)
+				return nullptr;
+			uintptr_t offset = strings.size() + 1;
+			strings.insert(strings.end(), str, str + std::strlen(str) + 1);
+			return reinterpret_cast<const char*>(offset);
+		}
+		const char* GetString(const char* stored) const {
+			uintptr_t offset = reinterpret_cast<uintptr_t>(stored);
+			return (offset != 0) ? strings.data() + offset - 1 : nullptr;
+		}
+	};
+	struct FILE_KEY // what a cached model has to match to be reused
+	{
+		unsigned long long size;
+		long long modified;
+		unsigned settingsHash;
+		bool exists;
+		bool operator==(const FILE_KEY& cmp) const {
+			return exists && cmp.exists && size == cmp.size &&
+				modified == cmp.modified && settingsHash == cmp.settingsHash;
+		}
+	};
+	struct STATS
+	{
+		size_t hits, misses, evictions, residentBytes, residentModels;
+	};
+
+	explicit ModelCache(size_t budgetBytes = 256ull * 1024 * 1024) : budget(budgetBytes) {}
+	ModelCache(const ModelCache&) = delete;
+	ModelCache& operator=(const ModelCache&) = delete;
+
+	// stat the file once, before it is read, so a change while importing isn't missed
+	static FILE_KEY KeyOf(const std::string& path, unsigned settingsHash) {
+		FILE_KEY key = { ~0ull, 0, settingsHash, false };
+		key.exists = VirtualFile::Stat(path.c_str(), key.size, key.modified);
+		return key;
+	}
+	// the cached model or nullptr, stale entries are dropped on the spot
+	std::shared_ptr<const MODEL_DATA> Find(const std::string& path, const FILE_KEY& key) {
+		std::lock_guard<std::mutex> lock(guard);
+		auto found = entries.find(path);
+		if (found != entries.end() && found->second.key == key) {
+			order.splice(order.begin(), order, found->second.use); // most recently used
+			++stats.hits;
+			return found->second.data;
+		}
+		if (found != entries.end())
+			Erase(found);
+		++stats.misses;
+		return nullptr;
+	}
+	void Insert(const std::string& path, const FILE_KEY& key, std::shared_ptr<const MODEL_DATA> data) {
+		if (key.exists == false || data == nullptr)
+			return;
+		std::lock_guard<std::mutex> lock(guard);
+		auto found = entries.find(path);
+		if (found != entries.end())
+			Erase(found);
+		order.push_front(path);
+		ENTRY& e = entries[path];
+		e.key = key;
+		e.bytes = data->Bytes();
+		e.data = std::move(data);
+		e.use = order.begin();
+		stats.residentBytes += e.bytes;
+		++stats.residentModels;
+		while (stats.residentBytes > budget && order.empty() == false) {
+			Erase(entries.find(order.back()));
+			++stats.evictions;
+		}
+	}
+	void SetBudget(size_t budgetBytes) {
+		std::lock_guard<std::mutex> lock(guard);
+		budget = budgetBytes;
+		while (stats.residentBytes > budget && order.empty() == false) {
+			Erase(entries.find(order.back()));
+			++stats.evictions;
+		}
+	}
+	void Clear() {
+		std::lock_guard<std::mutex> lock(guard);
+		entries.clear();
+		order.clear();
+		stats.residentBytes = stats.residentModels = 0;
+	}
+	STATS Stats() {
+		std::lock_guard<std::mutex> lock(guard);
+		return stats;
+	}
+private:
+	struct ENTRY
+	{
+		FILE_KEY key;
+		size_t bytes;
+		std::shared_ptr<const MODEL_DATA> data;
+		std::list<std::string>::iterator use; // position in "order"
+	};
+	void Erase(std::unordered_map<std::string, ENTRY>::iterator at) {
+		stats.residentBytes -= at->second.bytes;
+		--stats.residentModels;
+		order.erase(at->second.use);
+		entries.erase(at);
+	}
+	std::mutex guard;
+	size_t budget;
+	std::unordered_map<std::string, ENTRY> entries;
+	std::list<std::string> order; // front is the most recently used path
+	STATS stats = { 0, 0, 0, 0, 0 };
+};
+#endif
@@ -0,0 +1,31 @@
+#ifndef _PARALLELFOR_H_
+#define _PARALLELFOR_H_
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Runs task(i) for every i in [0, count) and returns once all of them are done.
+// Items are handed out one at a time so uneven work (big vs small models) balances itself.
+// Uses its own short lived threads instead of the gateware thread pool: that pool is shared
+// with GLog's writer and can be fully occupied by a background level load, in which case
+// a Converge() from inside it would never return.
+template<typename Task>
+void ParallelFor(size_t count, Task&& task, unsigned maxThreads = 0)
+{
+	unsigned threads = (maxThreads != 0) ? maxThreads : std::thread::hardware_concurrency();
+	threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, count)));
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t i = next++; i < count; i = next++)
+			task(i);
+	};
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+	for (unsigned t = 1; t < threads; ++t)
+		pool.emplace_back(worker);
+	worker(); // the calling thread works too
+	for (auto& t : pool)
+		t.join();
+}
+#endif
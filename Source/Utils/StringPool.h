@@ -0,0 +1,138 @@
+#ifndef _STRINGPOOL_H_
+#define _STRINGPOOL_H_
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Interns strings into a bump allocated arena.
+// Every unique string is stored once and gets a stable const char* plus a 32 bit id
+// (its insertion order) that can be turned back into the pointer with Get().
+// Clear() forgets everything in O(1): the arena rewinds and the hash index is
+// invalidated by bumping its generation, the memory is kept for the next level.
+// Release() actually frees it. Not thread safe, intern from one thread at a time.
+class StringPool
+{
+	static constexpr size_t BLOCK_SIZE = 64 * 1024;
+	struct BLOCK {
+		std::unique_ptr<char[]> data;
+		size_t size;
+	};
+	struct SLOT {
+		uint32_t hash, id, generation; // empty unless generation matches the pool's
+	};
+	std::vector<BLOCK> blocks;
+	size_t currentBlock = 0, blockUsed = 0, bytesUsed = 0;
+	std::vector<SLOT> index; // open addressing, power of two sized
+	std::vector<const char*> strings; // id -> string
+	std::vector<uint32_t> lengths; // id -> length, so lookups don't need strlen
+	uint32_t generation = 1;
+
+	static uint32_t Hash(const char* str, size_t length) {
+		uint32_t hash = 2166136261u; // FNV-1a
+		for (size_t i = 0; i < length; ++i)
+			hash = (hash ^ static_cast<unsigned char>(str[i])) * 16777619u;
+		return hash;
+	}
+	char* Allocate(size_t bytes) {
+		// walk (or add) blocks until one has room, rewound blocks are reused first
+		while (currentBlock < blocks.size() && blockUsed + bytes > blocks[currentBlock].size) {
+			++currentBlock;
+			blockUsed = 0;
+		}
+		if (currentBlock == blocks.size()) {
+			size_t size = (bytes > BLOCK_SIZE) ? bytes : BLOCK_SIZE;
+			blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+			blockUsed = 0;
+		}
+		char* at = blocks[currentBlock].data.get() + blockUsed;
+		blockUsed += bytes;
+		bytesUsed += bytes;
+		return at;
+	}
+	void Grow() {
+		std::vector<SLOT> bigger((index.empty() ? 256 : index.size() * 2), SLOT{ 0, 0, 0 });
+		index.swap(bigger);
+		for (uint32_t id = 0; id < strings.size(); ++id)
+			Insert(Hash(strings[id], lengths[id]), id);
+	}
+	void Insert(uint32_t hash, uint32_t id) {
+		size_t mask = index.size() - 1;
+		size_t at = hash & mask;
+		while (index[at].generation == generation)
+			at = (at + 1) & mask;
+		index[at] = { hash, id, generation };
+	}
+public:
+	StringPool() = default;
+	StringPool(const StringPool&) = delete;
+	StringPool& operator=(const StringPool&) = delete;
+	// blocks are heap owned so every pointer handed out survives a move
+	StringPool(StringPool&& that) noexcept { *this = static_cast<StringPool&&>(that); }
+	StringPool& operator=(StringPool&& that) noexcept {
+		if (this != &that) {
+			blocks.swap(that.blocks);
+			index.swap(that.index);
+			strings.swap(that.strings);
+			lengths.swap(that.lengths);
+			std::swap(currentBlock, that.currentBlock);
+			std::swap(blockUsed, that.blockUsed);
+			std::swap(bytesUsed, that.bytesUsed);
+			std::swap(generation, that.generation);
+			that.Release();
+		}
+		return *this;
+	}
+
+	// id of the string, adding it if it isn't in the pool yet
+	uint32_t Intern(const char* str, size_t length) {
+		if ((strings.size() + 1) * 2 > index.size()) // keep the load factor under 1/2
+			Grow();
+		uint32_t hash = Hash(str, length);
+		size_t mask = index.size() - 1;
+		for (size_t at = hash & mask; index[at].generation == generation; at = (at + 1) & mask) {
+			const SLOT& slot = index[at];
+			if (slot.hash == hash && lengths[slot.id] == length &&
+				std::memcmp(strings[slot.id], str, length) == 0)
+				return slot.id;
+		}
+		char* copy = Allocate(length + 1);
+		std::memcpy(copy, str, length);
+		copy[length] = '\0';
+		uint32_t id = static_cast<uint32_t>(strings.size());
+		strings.push_back(copy);
+		lengths.push_back(static_cast<uint32_t>(length));
+		Insert(hash, id);
+		return id;
+	}
+	uint32_t Intern(const char* str) { return Intern(str, std::strlen(str)); }
+	uint32_t Intern(const std::string& str) { return Intern(str.data(), str.size()); }
+	// pooled copy of the string, stays valid until Clear() or Release()
+	const char* InternString(const char* str) { return strings[Intern(str)]; }
+	const char* InternString(const std::string& str) { return strings[Intern(str)]; }
+
+	const char* Get(uint32_t id) const { return strings[id]; }
+	uint32_t Length(uint32_t id) const { return lengths[id]; }
+	size_t Count() const { return strings.size(); }
+	size_t BytesUsed() const { return bytesUsed; }
+
+	void Clear() {
+		strings.clear(); // pointers only, nothing to destroy
+		lengths.clear();
+		currentBlock = blockUsed = bytesUsed = 0;
+		if (++generation == 0) { // wrapped, stale slots could look valid again
+			std::fill(index.begin(), index.end(), SLOT{ 0, 0, 0 });
+			generation = 1;
+		}
+	}
+	void Release() {
+		Clear();
+		blocks.clear();
+		index.clear();
+		strings.shrink_to_fit();
+		lengths.shrink_to_fit();
+	}
+};
+#endif
@@ -0,0 +1,182 @@
+#ifndef _VERTEXPACKING_H_
+#define _VERTEXPACKING_H_
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "h2bParser.h"
+
+// Compact 16 byte alternative to H2B::VERTEX (36 bytes).
+// pos: 16 bit unorm relative to the model's bounding box (R16G16B16A16_UNORM)
+// uv:  half floats, the unused w coordinate is dropped (R16G16_FLOAT)
+// nrm: octahedral encoded unit vector (R16G16_SNORM)
+// VertexShader.hlsl reverses this using the bounds found in the MeshData cbuffer.
+namespace VertexPacking {
+
+#pragma pack(push,1)
+	struct PACKED_VERTEX {
+		uint16_t pos[4]; // w is padding
+		uint16_t uv[2];
+		int16_t nrm[2];
+	};
+#pragma pack(pop)
+	static_assert(sizeof(PACKED_VERTEX) == 16, "packed vertex must stay 16 bytes");
+
+	// range the positions of a model were quantized against
+	struct BOUNDS {
+		H2B::VECTOR min, extent;
+	};
+
+	inline uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, 4);
+		uint32_t sign = (bits >> 16) & 0x8000u;
+		uint32_t absBits = bits & 0x7FFFFFFFu;
+		if (absBits >= 0x7F800000u) // inf or nan
+			return static_cast<uint16_t>(sign | 0x7C00u | (absBits > 0x7F800000u ? 0x200u : 0u));
+		if (absBits >= 0x477FF000u) // rounds past the largest half, clamp to inf
+			return static_cast<uint16_t>(sign | 0x7C00u);
+		if (absBits < 0x38800000u) { // denormal half (or zero)
+			if (absBits < 0x33000000u)
+				return static_cast<uint16_t>(sign);
+			uint32_t mantissa = (absBits & 0x007FFFFFu) | 0x00800000u;
+			uint32_t shift = 126u - (absBits >> 23);
+			uint32_t half = mantissa >> shift;
+			uint32_t rest = mantissa & ((1u << shift) - 1u);
+			uint32_t midway = 1u << (shift - 1u);
+			if (rest > midway || (rest == midway && (half & 1u)))
+				++half; // round to nearest even
+			return static_cast<uint16_t>(sign | half);
+		}
+		uint32_t half = ((absBits - 0x38000000u) >> 13);
+		uint32_t rest = absBits & 0x1FFFu;
+		if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+			++half; // round to nearest even, may carry into the exponent which is correct
+		return static_cast<uint16_t>(sign | half);
+	}
+	inline float HalfToFloat(uint16_t half)
+	{
+		uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+		uint32_t exponent = (half >> 10) & 0x1Fu;
+		uint32_t mantissa = half & 0x3FFu;
+		uint32_t bits;
+		if (exponent == 0x1Fu)
+			bits = sign | 0x7F800000u | (mantissa << 13);
+		else if (exponent != 0)
+			bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+		else if (mantissa == 0)
+			bits = sign;
+		else { // denormal, normalize it
+			exponent = 113u;
+			while ((mantissa & 0x400u) == 0) {
+				mantissa <<= 1;
+				--exponent;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+		}
+		float value;
+		std::memcpy(&value, &bits, 4);
+		return value;
+	}
+	inline float SignNotZero(float v) { return (v >= 0.0f) ? 1.0f : -1.0f; }
+	inline int16_t ToSnorm16(float v)
+	{
+		return static_cast<int16_t>(std::lround(std::min(1.0f, std::max(-1.0f, v)) * 32767.0f));
+	}
+	inline void OctEncode(const H2B::VECTOR& n, int16_t out[2])
+	{
+		float len = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+		if (len <= 0.0f) { // degenerate normal, point it down +z
+			out[0] = out[1] = 0;
+			return;
+		}
+		float x = n.x / len, y = n.y / len;
+		if (n.z < 0.0f) { // fold the lower hemisphere over the diagonals
+			float fx = (1.0f - std::fabs(y)) * SignNotZero(x);
+			float fy = (1.0f - std::fabs(x)) * SignNotZero(y);
+			x = fx;
+			y = fy;
+		}
+		out[0] = ToSnorm16(x);
+		out[1] = ToSnorm16(y);
+	}
+	inline H2B::VECTOR OctDecode(const int16_t in[2])
+	{
+		float x = std::max(in[0] / 32767.0f, -1.0f);
+		float y = std::max(in[1] / 32767.0f, -1.0f);
+		float z = 1.0f - std::fabs(x) - std::fabs(y);
+		if (z < 0.0f) {
+			float fx = (1.0f - std::fabs(y)) * SignNotZero(x);
+			float fy = (1.0f - std::fabs(x)) * SignNotZero(y);
+			x = fx;
+			y = fy;
+		}
+		float len = std::sqrt(x * x + y * y + z * z);
+		return { x / len, y / len, z / len };
+	}
+
+	inline uint16_t QuantizeUnorm16(float value, float min, float extent)
+	{
+		if (extent <= 0.0f)
+			return 0;
+		float t = std::min(1.0f, std::max(0.0f, (value - min) / extent));
+		return static_cast<uint16_t>(std::lround(t * 65535.0f));
+	}
+	inline PACKED_VERTEX Pack(const H2B::VERTEX& v, const BOUNDS& b)
+	{
+		PACKED_VERTEX out;
+		out.pos[0] = QuantizeUnorm16(v.pos.x, b.min.x, b.extent.x);
+		out.pos[1] = QuantizeUnorm16(v.pos.y, b.min.y, b.extent.y);
+		out.pos[2] = QuantizeUnorm16(v.pos.z, b.min.z, b.extent.z);
+		out.pos[3] = 0;
+		out.uv[0] = FloatToHalf(v.uvw.x);
+		out.uv[1] = FloatToHalf(v.uvw.y);
+		OctEncode(v.nrm, out.nrm);
+		return out;
+	}
+	// CPU version of the vertex shader's dequantize step
+	inline H2B::VERTEX Unpack(const PACKED_VERTEX& v, const BOUNDS& b)
+	{
+		H2B::VERTEX out;
+		out.pos.x = b.min.x + v.pos[0] / 65535.0f * b.extent.x;
+		out.pos.y = b.min.y + v.pos[1] / 65535.0f * b.extent.y;
+		out.pos.z = b.min.z + v.pos[2] / 65535.0f * b.extent.z;
+		out.uvw.x = HalfToFloat(v.uv[0]);
+		out.uvw.y = HalfToFloat(v.uv[1]);
+		out.uvw.z = 0.0f;
+		out.nrm = OctDecode(v.nrm);
+		return out;
+	}
+
+	// worst case difference between original and packed->unpacked vertices
+	struct ROUND_TRIP_ERROR {
+		float position; // world units
+		float positionRelative; // position error / largest bounds extent
+		float uv;
+		float normalDegrees; // angle between the (normalized) original and decoded normal
+	};
+	inline void MeasureRoundTrip(const H2B::VERTEX* original, const PACKED_VERTEX* packed,
+		size_t count, const BOUNDS& b, ROUND_TRIP_ERROR& inOutWorst)
+	{
+		float largest = std::max(b.extent.x, std::max(b.extent.y, b.extent.z));
+		for (size_t i = 0; i < count; ++i) {
+			H2B::VERTEX back = Unpack(packed[i], b);
+			const H2B::VERTEX& v = original[i];
+			float dp = std::max(std::fabs(back.pos.x - v.pos.x),
+				std::max(std::fabs(back.pos.y - v.pos.y), std::fabs(back.pos.z - v.pos.z)));
+			float duv = std::max(std::fabs(back.uvw.x - v.uvw.x), std::fabs(back.uvw.y - v.uvw.y));
+			inOutWorst.position = std::max(inOutWorst.position, dp);
+			if (largest > 0.0f)
+				inOutWorst.positionRelative = std::max(inOutWorst.positionRelative, dp / largest);
+			inOutWorst.uv = std::max(inOutWorst.uv, duv);
+			float len = std::sqrt(v.nrm.x * v.nrm.x + v.nrm.y * v.nrm.y + v.nrm.z * v.nrm.z);
+			if (len > 0.0f) {
+				float cosAngle = (v.nrm.x * back.nrm.x + v.nrm.y * back.nrm.y + v.nrm.z * back.nrm.z) / len;
+				float degrees = std::acos(std::min(1.0f, std::max(-1.0f, cosAngle))) * 57.2957795f;
+				inOutWorst.normalDegrees = std::max(inOutWorst.normalDegrees, degrees);
+			}
+		}
+	}
+}
+#endif
@@ -0,0 +1,168 @@
+#ifndef _VIRTUALFILE_H_
+#define _VIRTUALFILE_H_
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Read only view of one asset, served from the mounted asset pack when it has the file
+// (a span straight into the pack's mapping, nothing is opened) or from the loose file
+// on disk otherwise. Mount() once at start up before anything is loaded, lookups are
+// read only afterwards so any thread may Open() files. Packed spans stay valid until
+// Unmount(), loose ones until Close(). Files packed compressed are inflated into a buffer
+// this VirtualFile owns, also until Close(), so are files read ahead and handed to Adopt().
+class VirtualFile
+{
+	MappedFile loose;
+	std::vector<unsigned char> inflated; // or adopted
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	bool packed = false;
+
+	static AssetPack::View& Pack() {
+		static AssetPack::View pack;
+		return pack;
+	}
+	struct INFLATED { std::mutex lock; BlockCompression::STATS stats; };
+	static INFLATED& Inflated() {
+		static INFLATED inflated;
+		return inflated;
+	}
+	// sizes "out" for a compressed entry once its stream agrees with the pack on the size,
+	// so a corrupt entry can't ask for an arbitrary allocation
+	static bool PrepareInflate(const AssetPack::ENTRY& e, std::vector<unsigned char>& out, BlockCompression::JOB& job) {
+		const unsigned char* stored = Pack().Data(e);
+		uint64_t rawSize = 0;
+		if (BlockCompression::RawSize(stored, static_cast<size_t>(e.stored), rawSize) == false || rawSize != e.size)
+			return false;
+		out.resize(static_cast<size_t>(e.size));
+		job = { stored, static_cast<size_t>(e.stored), out.data(), out.size() };
+		return true;
+	}
+	static void AddStats(const BlockCompression::STATS& stats) {
+		std::lock_guard<std::mutex> guard(Inflated().lock);
+		Inflated().stats.Add(stats);
+	}
+public:
+	VirtualFile() = default;
+	VirtualFile(const VirtualFile&) = delete;
+	VirtualFile& operator=(const VirtualFile&) = delete;
+
+	static bool Mount(const char* packPath) { return Pack().Open(packPath); }
+	static void Unmount() { Pack().Close(); }
+	static bool IsMounted() { return Pack().IsOpen(); }
+	// size and last write time like MappedFile::Stat, packed files report the pack's time
+	static bool Stat(const char* path, unsigned long long& outSize, long long& outModified) {
+		if (const AssetPack::ENTRY* e = Pack().Find(path)) {
+			outSize = e->size;
+			outModified = Pack().Modified();
+			return true;
+		}
+		return MappedFile::Stat(path, outSize, outModified);
+	}
+	// true when Open() would serve the file from the mounted pack
+	static bool InPack(const char* path) { return Pack().Find(path) != nullptr; }
+	// copies the first "bytes" of a file (a header) without mapping or inflating all of it
+	static bool ReadPrefix(const char* path, void* destination, size_t bytes) {
+		if (const AssetPack::ENTRY* e = Pack().Find(path)) {
+			if (bytes > e->size)
+				return false;
+			if (AssetPack::View::Compressed(*e))
+				return BlockCompression::DecompressPrefix(Pack().Data(*e),
+					static_cast<size_t>(e->stored), destination, bytes);
+			std::memcpy(destination, Pack().Data(*e), bytes);
+			return true;
+		}
+		MappedFile file; // only the pages holding the prefix are ever read
+		if (file.Open(path) == false || file.Size() < bytes)
+			return false;
+		std::memcpy(destination, file.Data(), bytes);
+		return true;
+	}
+	// true when Open() would have to inflate the file out of the pack
+	static bool PackedCompressed(const char* path) {
+		const AssetPack::ENTRY* e = Pack().Find(path);
+		return e != nullptr && AssetPack::View::Compressed(*e);
+	}
+	// Inflates several packed compressed files with one Decompress call, so the blocks of all
+	// of them share one set of threads. Open() from inside a ParallelFor worker would start a
+	// set per file instead. ok[i] is false for files that aren't packed compressed or are corrupt.
+	static std::vector<char> InflateAll(const std::vector<std::string>& paths, std::vector<std::vector<unsigned char>>& outBytes) {
+		std::vector<char> ok(paths.size(), 0);
+		std::vector<BlockCompression::JOB> jobs;
+		std::vector<size_t> owners; // path of each job
+		outBytes.assign(paths.size(), std::vector<unsigned char>());
+		for (size_t i = 0; i < paths.size(); ++i) {
+			const AssetPack::ENTRY* e = Pack().Find(paths[i].c_str());
+			BlockCompression::JOB job;
+			if (e == nullptr || AssetPack::View::Compressed(*e) == false || PrepareInflate(*e, outBytes[i], job) == false)
+				continue;
+			jobs.push_back(job);
+			owners.push_back(i);
+		}
+		BlockCompression::STATS stats;
+		if (BlockCompression::Decompress(jobs, &stats)) {
+			for (size_t owner : owners)
+				ok[owner] = 1;
+			AddStats(stats);
+			return ok;
+		}
+		for (size_t j = 0; j < jobs.size(); ++j) // one is corrupt, find out which on their own
+			ok[owners[j]] = BlockCompression::Decompress(std::vector<BlockCompression::JOB>{ jobs[j] }) ? 1 : 0;
+		return ok;
+	}
+	// everything inflated out of the pack so far, for throughput reports
+	static BlockCompression::STATS InflateStats() {
+		std::lock_guard<std::mutex> guard(Inflated().lock);
+		return Inflated().stats;
+	}
+
+	bool Open(const char* path) {
+		Close();
+		if (const AssetPack::ENTRY* e = Pack().Find(path)) {
+			data = Pack().Data(*e);
+			size = static_cast<size_t>(e->size);
+			packed = true;
+			if (AssetPack::View::Compressed(*e)) {
+				BlockCompression::JOB job;
+				BlockCompression::STATS stats;
+				if (PrepareInflate(*e, inflated, job) == false ||
+					BlockCompression::Decompress(std::vector<BlockCompression::JOB>{ job }, &stats) == false) {
+					Close();
+					return false; // corrupt pack
+				}
+				data = inflated.data();
+				AddStats(stats);
+			}
+			return true;
+		}
+		if (loose.Open(path) == false)
+			return false;
+		data = loose.Data();
+		size = loose.Size();
+		return true;
+	}
+	// serves a whole file somebody already read into memory (see BatchRead.h)
+	void Adopt(std::vector<unsigned char>&& bytes) {
+		Close();
+		inflated = std::move(bytes);
+		data = inflated.data();
+		size = inflated.size();
+	}
+	void Close() {
+		loose.Close();
+		inflated = std::vector<unsigned char>();
+		data = nullptr;
+		size = 0;
+		packed = false;
+	}
+	const unsigned char* Data() const { return data; }
+	size_t Size() const { return size; }
+	std::string_view Text() const { return std::string_view(reinterpret_cast<const char*>(data), size); }
+	bool FromPack() const { return packed; }
+};
+#endif
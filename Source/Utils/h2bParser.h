@@ -1,8 +1,13 @@
 #ifndef _H2BPARSER_H_
 #define _H2BPARSER_H_
+#include <algorithm>
 #include <fstream>
+#include <string>
+#include <unordered_map>
 #include <vector>
-#include <set>
+#include <cstring>
+#include "VirtualFile.h"
+#include "StringPool.h"
 
 namespace H2B {
 
@@ -43,10 +48,418 @@ namespace H2B {
 		BATCH drawInfo;
 		unsigned materialIndex;
 	};
+	// *V2*
+	// Sectioned layout (Tools/H2BConverter). The v1 layout interleaves strings with the
+	// records so nothing can be found without parsing all that comes before it. v2 has a
+	// section table and puts every section on a 16 byte boundary, strings go into one table
+	// referred to by offset and each mesh records its own vertex range and LODs:
+	//	HEADER_V2 | SECTION[sectionCount] | sections, each 16 byte aligned, in any order
+	// The counts sit where v1 keeps them, so header only readers (ReadCounts) handle both.
+	// Readers that predate v2 reject its version, unknown section types are skipped.
+	static constexpr char VERSION_2[4] = { '0', '2', '0', 'a' };
+	static constexpr unsigned SECTION_ALIGNMENT = 16;
+	enum SECTION_TYPE : unsigned {
+		SECTION_VERTICES = 1, // VERTEX[vertexCount]
+		SECTION_INDICES, // unsigned[indexCount]
+		SECTION_MATERIALS, // MATERIAL_V2[materialCount]
+		SECTION_BATCHES, // BATCH[materialCount]
+		SECTION_MESHES, // MESH_V2[meshCount]
+		SECTION_STRINGS, // null terminated strings back to back
+		SECTION_LODS, // LOD_V2[lodCount], optional
+		SECTION_LOD_INDICES, // unsigned[], what LOD_V2 ranges index into (model vertices), optional
+	};
+#pragma pack(push,1)
+	struct HEADER_V2 {
+		char version[4]; // VERSION_2
+		unsigned vertexCount, indexCount, materialCount, meshCount; // same place as v1
+		unsigned sectionCount;
+		unsigned lodCount; // LOD_V2 records, 0 without LODs
+		unsigned reserved;
+	};
+	struct SECTION {
+		unsigned type, reserved;
+		unsigned long long offset, bytes; // from the start of the file
+	};
+	struct MATERIAL_V2 {
+		unsigned char attrib[sizeof(ATTRIBUTES)];
+		unsigned strings[10]; // name, map_Kd ... bump as STRINGS offsets + 1, 0 for none
+		unsigned reserved[2];
+	};
+	struct MESH_V2 {
+		unsigned name; // STRINGS offset + 1, 0 for none
+		BATCH drawInfo;
+		unsigned materialIndex;
+		unsigned vertexStart, vertexCount; // every vertex the mesh (and its LODs) uses
+		unsigned lodStart, lodCount; // LOD_V2 records of the simplified levels, the original isn't one
+	};
+	struct LOD_V2 {
+		unsigned indexCount, indexOffset; // into SECTION_LOD_INDICES
+		float error; // largest distance (model units) the surface moved
+		unsigned reserved;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(HEADER_V2) == 32 && sizeof(SECTION) == 24 && sizeof(MATERIAL_V2) == 128 &&
+		sizeof(MESH_V2) == 32 && sizeof(LOD_V2) == 16, "H2B v2 records are fixed size on disk");
+	inline bool IsVersion2(const char* version) { return std::memcmp(version, VERSION_2, 4) == 0; }
+	inline bool KnownVersion(const char* version) {
+		return IsVersion2(version) || (version[1] >= '1' && version[2] >= '9' && version[3] >= 'd');
+	}
+	// the sizes at the front of every .h2b
+	struct COUNTS {
+		unsigned vertexCount, indexCount, materialCount, meshCount;
+	};
+	// reads just the 20 byte header, enough to size arrays before any model is loaded
+	inline bool ReadCounts(const char* h2bPath, COUNTS& out)
+	{
+		char header[20];
+		if (VirtualFile::ReadPrefix(h2bPath, header, sizeof(header)) == false)
+			return false;
+		if (KnownVersion(header) == false)
+			return false;
+		std::memcpy(&out, header + 4, sizeof(COUNTS));
+		return true;
+	}
+	// Zero-copy reader: maps the .h2b file (finds it in the mounted asset pack, or
+	// takes over bytes that were read ahead) and points straight into it. Vertex, index and batch arrays plus every string
+	// are read in place, only the small MATERIAL/MESH headers are unpacked.
+	// Reads v1 and v2 files alike. A v2 Open() without checkIndices only looks at the section
+	// table, materials and meshes, the geometry pages aren't touched until something reads them.
+	// All pointers are invalidated by Close(), Open() or destroying the View.
+	class View
+	{
+		VirtualFile file;
+	public:
+		char version[4];
+		unsigned vertexCount;
+		unsigned indexCount;
+		unsigned materialCount;
+		unsigned meshCount;
+		const VERTEX* vertices;
+		const unsigned* indices;
+		const BATCH* batches;
+		std::vector<MATERIAL> materials; // string pointers refer to the mapping
+		std::vector<MESH> meshes; // name pointers refer to the mapping
+		// v2 only, empty for v1 files
+		const MESH_V2* meshRecords;
+		const LOD_V2* lods;
+		unsigned lodCount;
+		const unsigned* lodIndices;
+		unsigned lodIndexCount;
+		// where one mesh's geometry lies, for reading a single mesh or LOD on its own.
+		// Indices refer to the model's vertices, subtract vertexStart to make them local.
+		struct MESH_RANGE {
+			const VERTEX* vertices; // vertices + vertexStart
+			unsigned vertexStart, vertexCount;
+			const unsigned* indices;
+			unsigned indexCount;
+			float error; // of the LOD, 0 for the original
+		};
+		View() { Clear(); }
+		// maps the file and validates every section against the file size. checkIndices
+		// also verifies every index (LODs included) names a vertex, an O(n) pass over the
+		// index data. Only callers that check the indices they use themselves (ReadMesh)
+		// may skip it, everything handed to the loader has to pass it.
+		bool Open(const char* h2bPath, bool checkIndices = true)
+		{
+			Close();
+			if (file.Open(h2bPath) == false)
+				return false;
+			if (Validate(checkIndices) == false) {
+				Close();
+				return false;
+			}
+			return true;
+		}
+		// same for a file that was already read into memory, the View keeps the bytes
+		bool Adopt(std::vector<unsigned char>&& bytes)
+		{
+			Close();
+			file.Adopt(std::move(bytes));
+			if (Validate(true) == false) {
+				Close();
+				return false;
+			}
+			return true;
+		}
+		void Close()
+		{
+			file.Close();
+			Clear();
+		}
+		size_t FileSize() const { return file.Size(); }
+		bool Sectioned() const { return IsVersion2(version); }
+		// levels a mesh can be read at, the original included
+		unsigned LevelCount(unsigned mesh) const {
+			return (mesh < meshCount && meshRecords != nullptr) ? 1 + meshRecords[mesh].lodCount : 1;
+		}
+		// lod 0 is the mesh itself. v1 files have no stored LODs and no vertex ranges,
+		// there the range is found from the mesh's own indices.
+		bool MeshRange(unsigned mesh, unsigned lod, MESH_RANGE& out) const {
+			if (mesh >= meshCount || lod >= LevelCount(mesh))
+				return false;
+			const BATCH& draw = meshes[mesh].drawInfo;
+			out.indices = indices + draw.indexOffset;
+			out.indexCount = draw.indexCount;
+			out.error = 0.0f;
+			if (lod != 0) {
+				const LOD_V2& l = lods[meshRecords[mesh].lodStart + lod - 1];
+				out.indices = lodIndices + l.indexOffset;
+				out.indexCount = l.indexCount;
+				out.error = l.error;
+			}
+			if (meshRecords != nullptr) {
+				out.vertexStart = meshRecords[mesh].vertexStart;
+				out.vertexCount = meshRecords[mesh].vertexCount;
+			}
+			else {
+				unsigned low = ~0u, high = 0;
+				for (unsigned i = 0; i < out.indexCount; ++i) {
+					low = std::min(low, out.indices[i]);
+					high = std::max(high, out.indices[i]);
+				}
+				if (out.indexCount != 0 && high >= vertexCount)
+					return false;
+				out.vertexStart = (out.indexCount != 0) ? low : 0;
+				out.vertexCount = (out.indexCount != 0) ? high - low + 1 : 0;
+			}
+			out.vertices = vertices + out.vertexStart;
+			return true;
+		}
+	private:
+		void Clear()
+		{
+			*reinterpret_cast<unsigned*>(version) = 0;
+			vertexCount = indexCount = materialCount = meshCount = 0;
+			vertices = nullptr;
+			indices = nullptr;
+			batches = nullptr;
+			materials.clear();
+			meshes.clear();
+			meshRecords = nullptr;
+			lods = nullptr;
+			lodCount = lodIndexCount = 0;
+			lodIndices = nullptr;
+		}
+		// returns a null terminated string at "at" or fails if it runs off the end
+		static bool ReadString(const unsigned char*& at, const unsigned char* end, const char*& out)
+		{
+			const void* terminator = std::memchr(at, '\0', end - at);
+			if (terminator == nullptr)
+				return false;
+			out = (*at != '\0') ? reinterpret_cast<const char*>(at) : nullptr;
+			at = static_cast<const unsigned char*>(terminator) + 1;
+			return true;
+		}
+		bool Validate(bool checkIndices)
+		{
+			const unsigned char* at = file.Data();
+			const unsigned char* end = at + file.Size();
+			if (file.Size() < 20)
+				return false;
+			std::memcpy(version, at, 4);
+			if (IsVersion2(version))
+				return ValidateSections() && ValidateRanges(checkIndices);
+			if (KnownVersion(version) == false)
+				return false;
+			std::memcpy(&vertexCount, at + 4, 4);
+			std::memcpy(&indexCount, at + 8, 4);
+			std::memcpy(&materialCount, at + 12, 4);
+			std::memcpy(&meshCount, at + 16, 4);
+			at += 20;
+			// fixed size sections, checked in 64 bits so huge counts can't wrap
+			unsigned long long fixedBytes = 36ull * vertexCount + 4ull * indexCount;
+			if (fixedBytes > static_cast<unsigned long long>(end - at))
+				return false;
+			vertices = reinterpret_cast<const VERTEX*>(at);
+			at += 36ull * vertexCount;
+			indices = reinterpret_cast<const unsigned*>(at);
+			at += 4ull * indexCount;
+			// materials are 80 bytes of attributes followed by 10 strings
+			materials.resize(materialCount);
+			for (unsigned i = 0; i < materialCount; ++i) {
+				if (end - at < 80)
+					return false;
+				std::memcpy(&materials[i].attrib, at, 80);
+				at += 80;
+				for (int j = 0; j < 10; ++j)
+					if (ReadString(at, end, *((&materials[i].name) + j)) == false)
+						return false;
+				materials[i].padding[0] = materials[i].padding[1] = nullptr;
+			}
+			if (8ull * materialCount > static_cast<unsigned long long>(end - at))
+				return false;
+			batches = reinterpret_cast<const BATCH*>(at);
+			at += 8ull * materialCount;
+			meshes.resize(meshCount);
+			for (unsigned i = 0; i < meshCount; ++i) {
+				if (ReadString(at, end, meshes[i].name) == false || end - at < 12)
+					return false;
+				std::memcpy(&meshes[i].drawInfo, at, 8);
+				std::memcpy(&meshes[i].materialIndex, at + 8, 4);
+				at += 12;
+			}
+			return ValidateRanges(checkIndices);
+		}
+		// every draw range has to stay inside this file's index data and every index has to
+		// name one of its vertices, the weld and cache passes write through them
+		bool ValidateRanges(bool checkIndices) const
+		{
+			if (checkIndices) {
+				for (unsigned i = 0; i < indexCount; ++i)
+					if (indices[i] >= vertexCount)
+						return false;
+				for (unsigned i = 0; i < lodIndexCount; ++i)
+					if (lodIndices[i] >= vertexCount)
+						return false;
+			}
+			for (unsigned i = 0; i < materialCount; ++i)
+				if (static_cast<unsigned long long>(batches[i].indexOffset) +
+					batches[i].indexCount > indexCount)
+					return false;
+			for (unsigned i = 0; i < meshCount; ++i)
+				if (static_cast<unsigned long long>(meshes[i].drawInfo.indexOffset) +
+					meshes[i].drawInfo.indexCount > indexCount)
+					return false;
+			return true;
+		}
+		// v2: finds every section through the table and checks its size and alignment,
+		// only the material and mesh records are unpacked
+		bool ValidateSections()
+		{
+			const unsigned char* base = file.Data();
+			const unsigned long long size = file.Size();
+			if (size < sizeof(HEADER_V2))
+				return false;
+			HEADER_V2 header;
+			std::memcpy(&header, base, sizeof(header));
+			if (header.sectionCount > (size - sizeof(HEADER_V2)) / sizeof(SECTION))
+				return false;
+			vertexCount = header.vertexCount;
+			indexCount = header.indexCount;
+			materialCount = header.materialCount;
+			meshCount = header.meshCount;
+			lodCount = header.lodCount;
+			const SECTION* table = reinterpret_cast<const SECTION*>(base + sizeof(HEADER_V2));
+			const SECTION* found[SECTION_LOD_INDICES + 1] = {};
+			for (unsigned i = 0; i < header.sectionCount; ++i) {
+				const SECTION& section = table[i];
+				if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > size || section.bytes > size - section.offset)
+					return false;
+				if (section.type == 0 || section.type > SECTION_LOD_INDICES)
+					continue; // from a newer writer
+				if (found[section.type] != nullptr)
+					return false;
+				found[section.type] = &section;
+			}
+			// a section may only be left out when it would be empty
+			auto locate = [&](unsigned type, unsigned long long count, unsigned long long stride, const unsigned char*& out) {
+				out = nullptr;
+				if (found[type] == nullptr)
+					return count == 0;
+				out = base + found[type]->offset;
+				return found[type]->bytes == count * stride;
+			};
+			const unsigned char *vertexBytes, *indexBytes, *materialBytes, *batchBytes, *meshBytes, *lodBytes, *lodIndexBytes;
+			if (locate(SECTION_VERTICES, vertexCount, sizeof(VERTEX), vertexBytes) == false ||
+				locate(SECTION_INDICES, indexCount, 4, indexBytes) == false ||
+				locate(SECTION_MATERIALS, materialCount, sizeof(MATERIAL_V2), materialBytes) == false ||
+				locate(SECTION_BATCHES, materialCount, sizeof(BATCH), batchBytes) == false ||
+				locate(SECTION_MESHES, meshCount, sizeof(MESH_V2), meshBytes) == false ||
+				locate(SECTION_LODS, lodCount, sizeof(LOD_V2), lodBytes) == false)
+				return false;
+			const SECTION* lodIndexSection = found[SECTION_LOD_INDICES];
+			if (lodIndexSection != nullptr && (lodIndexSection->bytes % 4 != 0 || lodIndexSection->bytes / 4 > ~0u))
+				return false;
+			lodIndexCount = (lodIndexSection != nullptr) ? static_cast<unsigned>(lodIndexSection->bytes / 4) : 0;
+			locate(SECTION_LOD_INDICES, lodIndexCount, 4, lodIndexBytes);
+			// the string table has to end on a terminator so no lookup can run off it
+			const SECTION* strings = found[SECTION_STRINGS];
+			const char* stringBytes = (strings != nullptr) ? reinterpret_cast<const char*>(base + strings->offset) : nullptr;
+			const unsigned long long stringSize = (strings != nullptr) ? strings->bytes : 0;
+			if (stringSize != 0 && stringBytes[stringSize - 1] != '\0')
+				return false;
+			auto string = [&](unsigned reference, const char*& out) {
+				out = nullptr;
+				if (reference == 0)
+					return true;
+				if (reference - 1ull >= stringSize)
+					return false;
+				if (stringBytes[reference - 1] != '\0') // empty strings read as none, like v1
+					out = stringBytes + reference - 1;
+				return true;
+			};
+			vertices = reinterpret_cast<const VERTEX*>(vertexBytes);
+			indices = reinterpret_cast<const unsigned*>(indexBytes);
+			batches = reinterpret_cast<const BATCH*>(batchBytes);
+			meshRecords = reinterpret_cast<const MESH_V2*>(meshBytes);
+			lods = reinterpret_cast<const LOD_V2*>(lodBytes);
+			lodIndices = reinterpret_cast<const unsigned*>(lodIndexBytes);
+			const MATERIAL_V2* materialRecords = reinterpret_cast<const MATERIAL_V2*>(materialBytes);
+			materials.resize(materialCount);
+			for (unsigned i = 0; i < materialCount; ++i) {
+				std::memcpy(&materials[i].attrib, materialRecords[i].attrib, sizeof(ATTRIBUTES));
+				for (int j = 0; j < 10; ++j)
+					if (string(materialRecords[i].strings[j], *((&materials[i].name) + j)) == false)
+						return false;
+				materials[i].padding[0] = materials[i].padding[1] = nullptr;
+			}
+			meshes.resize(meshCount);
+			for (unsigned i = 0; i < meshCount; ++i) {
+				const MESH_V2& record = meshRecords[i];
+				if (string(record.name, meshes[i].name) == false)
+					return false;
+				meshes[i].drawInfo = record.drawInfo;
+				meshes[i].materialIndex = record.materialIndex;
+				if (static_cast<unsigned long long>(record.vertexStart) + record.vertexCount > vertexCount ||
+					static_cast<unsigned long long>(record.lodStart) + record.lodCount > lodCount)
+					return false;
+			}
+			for (unsigned i = 0; i < lodCount; ++i)
+				if (static_cast<unsigned long long>(lods[i].indexOffset) + lods[i].indexCount > lodIndexCount)
+					return false;
+			return true;
+		}
+	};
+	// one mesh of a model at one level of detail, with only the vertices it uses
+	struct MESH_DATA {
+		std::vector<VERTEX> vertices;
+		std::vector<unsigned> indices; // into vertices above
+		std::string name;
+		unsigned materialIndex = 0;
+		float error = 0.0f;
+	};
+	// Reads a single mesh (or one of its LODs) without the rest of the model. With a v2
+	// file only the tables and that mesh's own vertex and index ranges are ever paged in,
+	// so the index check is limited to the range that is read.
+	inline bool ReadMesh(const char* h2bPath, unsigned mesh, unsigned lod, MESH_DATA& out)
+	{
+		View view;
+		View::MESH_RANGE range;
+		if (view.Open(h2bPath, false) == false || view.MeshRange(mesh, lod, range) == false)
+			return false;
+		out.vertices.assign(range.vertices, range.vertices + range.vertexCount);
+		out.indices.resize(range.indexCount);
+		for (unsigned i = 0; i < range.indexCount; ++i) {
+			out.indices[i] = range.indices[i] - range.vertexStart;
+			if (out.indices[i] >= range.vertexCount)
+				return false; // a LOD reaching outside the range its mesh recorded
+		}
+		out.name = (view.meshes[mesh].name != nullptr) ? view.meshes[mesh].name : "";
+		out.materialIndex = view.meshes[mesh].materialIndex;
+		out.error = range.error;
+		return true;
+	}
 	class Parser
 	{
-		std::set<std::string> file_strings;
+		StringPool file_strings;
+		StringPool* strings; // file_strings unless the caller shares its own pool
 	public:
+		// pass a pool to intern names straight into it, e.g. the level's,
+		// so they aren't copied a second time after parsing
+		explicit Parser(StringPool* sharedStrings = nullptr)
+			: strings(sharedStrings != nullptr ? sharedStrings : &file_strings) {}
+		Parser(const Parser&) = delete; // "strings" may point at our own file_strings
+		Parser& operator=(const Parser&) = delete;
 		char version[4];
 		unsigned vertexCount;
 		unsigned indexCount;
@@ -57,59 +470,36 @@ namespace H2B {
 		std::vector<MATERIAL> materials;
 		std::vector<BATCH> batches;
 		std::vector<MESH> meshes;
+		// copies everything out of a View, so it reads packed files too
 		bool Parse(const char* h2bPath)
 		{
 			Clear();
-			std::ifstream file;
-			char buffer[260] = { 0, };
-			file.open(h2bPath,	std::ios_base::in | 
-								std::ios_base::binary);
-			if (file.is_open() == false)
+			View view;
+			if (view.Open(h2bPath) == false)
 				return false;
-			file.read(version, 4);
-			if (version[1] < '1' || version[2] < '9' || version[3] < 'd')
-				return false;
-			file.read(reinterpret_cast<char*>(&vertexCount), 4);
-			file.read(reinterpret_cast<char*>(&indexCount), 4);
-			file.read(reinterpret_cast<char*>(&materialCount), 4);
-			file.read(reinterpret_cast<char*>(&meshCount), 4);
-			vertices.resize(vertexCount);
-			file.read(reinterpret_cast<char*>(vertices.data()), 36 * vertexCount);
-			indices.resize(indexCount);
-			file.read(reinterpret_cast<char*>(indices.data()), 4 * indexCount);
-			materials.resize(materialCount);
-			for (int i = 0; i < materialCount; ++i) {
-				file.read(reinterpret_cast<char*>(&materials[i].attrib), 80);
-				for (int j = 0; j < 10; ++j) {
-					buffer[0] = '\0';
-					*((&materials[i].name) + j) = nullptr;
-					file.getline(buffer, 260, '\0');
-					if (buffer[0] != '\0') {
-						auto last = file_strings.insert(buffer);
-						*((&materials[i].name) + j) = last.first->c_str();
-					}
-				}
-			}
-			batches.resize(materialCount);
-			file.read(reinterpret_cast<char*>(batches.data()), 8 * materialCount);
-			meshes.resize(meshCount);
-			for (int i = 0; i < meshCount; ++i) {
-				buffer[0] = '\0';
-				meshes[i].name = nullptr;
-				file.getline(buffer, 260, '\0');
-				if (buffer[0] != '\0') {
-					auto last = file_strings.insert(buffer);
-					meshes[i].name = last.first->c_str();
-				}
-				file.read(reinterpret_cast<char*>(&meshes[i].drawInfo), 8);
-				file.read(reinterpret_cast<char*>(&meshes[i].materialIndex), 4);
-			}
+			std::memcpy(version, view.version, 4);
+			vertexCount = view.vertexCount;
+			indexCount = view.indexCount;
+			materialCount = view.materialCount;
+			meshCount = view.meshCount;
+			vertices.assign(view.vertices, view.vertices + vertexCount);
+			indices.assign(view.indices, view.indices + indexCount);
+			materials = view.materials;
+			for (MATERIAL& m : materials)
+				for (int j = 0; j < 10; ++j)
+					if (*((&m.name) + j) != nullptr)
+						*((&m.name) + j) = strings->InternString(*((&m.name) + j));
+			batches.assign(view.batches, view.batches + materialCount);
+			meshes = view.meshes;
+			for (MESH& m : meshes)
+				if (m.name != nullptr)
+					m.name = strings->InternString(m.name);
 			return true;
 		}
 		void Clear()
 		{
 			*reinterpret_cast<unsigned*>(version) = 0;
-			file_strings.clear();
+			file_strings.Clear(); // a shared pool belongs to the caller
 			vertices.clear();
 			indices.clear();
 			materials.clear();
@@ -117,5 +507,128 @@ namespace H2B {
 			meshes.clear();
 		}
 	};
+	// Writes v2 files: a model taken from any View plus optional simplified index lists
+	// per mesh, added from finest to coarsest and indexing the model's vertices.
+	class Builder
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<unsigned> indices;
+		std::vector<BATCH> batches;
+		std::vector<MATERIAL_V2> materials;
+		std::vector<MESH_V2> meshes;
+		std::vector<std::vector<LOD_V2>> meshLods;
+		std::vector<unsigned> lodIndices;
+		std::vector<char> strings;
+		std::unordered_map<std::string, unsigned> stringOffsets;
+
+		unsigned AddString(const char* str) {
+			if (str == nullptr)
+				return 0;
+			auto found = stringOffsets.emplace(str, static_cast<unsigned>(strings.size()) + 1);
+			if (found.second)
+				strings.insert(strings.end(), str, str + std::strlen(str) + 1);
+			return found.first->second;
+		}
+	public:
+		void SetModel(const View& source) {
+			*this = Builder();
+			vertices.assign(source.vertices, source.vertices + source.vertexCount);
+			indices.assign(source.indices, source.indices + source.indexCount);
+			batches.assign(source.batches, source.batches + source.materialCount);
+			for (const MATERIAL& m : source.materials) {
+				MATERIAL_V2 record = {};
+				std::memcpy(record.attrib, &m.attrib, sizeof(ATTRIBUTES));
+				for (int j = 0; j < 10; ++j)
+					record.strings[j] = AddString(*((&m.name) + j));
+				materials.push_back(record);
+			}
+			for (const MESH& m : source.meshes) {
+				MESH_V2 record = {};
+				record.name = AddString(m.name);
+				record.drawInfo = m.drawInfo;
+				record.materialIndex = m.materialIndex;
+				meshes.push_back(record);
+			}
+			meshLods.resize(meshes.size());
+		}
+		// appends the next coarser level of a mesh
+		bool AddLod(unsigned mesh, const std::vector<unsigned>& lod, float error) {
+			if (mesh >= meshes.size())
+				return false;
+			for (unsigned index : lod)
+				if (index >= vertices.size())
+					return false;
+			meshLods[mesh].push_back({ static_cast<unsigned>(lod.size()), static_cast<unsigned>(lodIndices.size()), error, 0 });
+			lodIndices.insert(lodIndices.end(), lod.begin(), lod.end());
+			return true;
+		}
+		bool Write(const char* path, unsigned long long* outBytes = nullptr) {
+			// vertex range of every mesh, its LODs included
+			std::vector<LOD_V2> lods;
+			for (size_t i = 0; i < meshes.size(); ++i) {
+				MESH_V2& m = meshes[i];
+				unsigned low = ~0u, high = 0;
+				auto cover = [&](const unsigned* at, unsigned count) {
+					for (unsigned k = 0; k < count; ++k) {
+						low = std::min(low, at[k]);
+						high = std::max(high, at[k]);
+					}
+				};
+				if (static_cast<unsigned long long>(m.drawInfo.indexOffset) + m.drawInfo.indexCount > indices.size())
+					return false;
+				cover(indices.data() + m.drawInfo.indexOffset, m.drawInfo.indexCount);
+				for (const LOD_V2& l : meshLods[i])
+					cover(lodIndices.data() + l.indexOffset, l.indexCount);
+				m.vertexStart = (low <= high) ? low : 0;
+				m.vertexCount = (low <= high) ? high - low + 1 : 0;
+				m.lodStart = static_cast<unsigned>(lods.size());
+				m.lodCount = static_cast<unsigned>(meshLods[i].size());
+				lods.insert(lods.end(), meshLods[i].begin(), meshLods[i].end());
+			}
+			struct PART { SECTION_TYPE type; const void* data; size_t bytes; };
+			const PART parts[] = {
+				{ SECTION_VERTICES, vertices.data(), vertices.size() * sizeof(VERTEX) },
+				{ SECTION_INDICES, indices.data(), indices.size() * 4 },
+				{ SECTION_MATERIALS, materials.data(), materials.size() * sizeof(MATERIAL_V2) },
+				{ SECTION_BATCHES, batches.data(), batches.size() * sizeof(BATCH) },
+				{ SECTION_MESHES, meshes.data(), meshes.size() * sizeof(MESH_V2) },
+				{ SECTION_STRINGS, strings.data(), strings.size() },
+				{ SECTION_LODS, lods.data(), lods.size() * sizeof(LOD_V2) },
+				{ SECTION_LOD_INDICES, lodIndices.data(), lodIndices.size() * 4 },
+			};
+			const unsigned sectionCount = sizeof(parts) / sizeof(parts[0]);
+			HEADER_V2 header = {};
+			std::memcpy(header.version, VERSION_2, 4);
+			header.vertexCount = static_cast<unsigned>(vertices.size());
+			header.indexCount = static_cast<unsigned>(indices.size());
+			header.materialCount = static_cast<unsigned>(materials.size());
+			header.meshCount = static_cast<unsigned>(meshes.size());
+			header.sectionCount = sectionCount;
+			header.lodCount = static_cast<unsigned>(lods.size());
+			auto align = [](unsigned long long at) { return (at + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1ull); };
+			SECTION table[sectionCount];
+			unsigned long long at = align(sizeof(HEADER_V2) + sizeof(table));
+			for (unsigned i = 0; i < sectionCount; ++i) {
+				table[i] = { static_cast<unsigned>(parts[i].type), 0, at, parts[i].bytes };
+				at = align(at + parts[i].bytes);
+			}
+			std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			if (file.is_open() == false)
+				return false;
+			const char zeros[SECTION_ALIGNMENT] = {};
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(table), sizeof(table));
+			unsigned long long written = sizeof(header) + sizeof(table);
+			for (unsigned i = 0; i < sectionCount; ++i) {
+				file.write(zeros, static_cast<std::streamsize>(table[i].offset - written));
+				file.write(static_cast<const char*>(parts[i].data), static_cast<std::streamsize>(parts[i].bytes));
+				written = table[i].offset + parts[i].bytes;
+			}
+			file.write(zeros, static_cast<std::streamsize>(at - written)); // the file ends aligned too
+			if (outBytes != nullptr)
+				*outBytes = at;
+			return file.good();
+		}
+	};
 }
 #endif
\ No newline at end of file
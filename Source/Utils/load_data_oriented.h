@@ -4,18 +4,47 @@
 
 // This reads .h2b files which are optimized binary .obj+.mtl files
 #include "h2bParser.h"
+#include "StringPool.h"
+#include "ParallelFor.h"
+#include "VertexPacking.h"
+#include "MeshOptimizer.h"
+#include "Bounds.h"
+#include "BlockCompression.h"
+#include "BatchRead.h"
+#include "ModelCache.h"
+#include "GameLevelReader.h"
+#include "LevelLayout.h"
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#if defined(__linux__)
+	#include <sys/mman.h>
+#endif
 
 class Level_Data {
 
 	// transfered from parser
-	std::set<std::string> level_strings;
+	StringPool level_strings; // interned names, freed in one go by UnloadLevel
+	// when loaded from a cooked .lvlbin every string points into this mapping
+	MappedFile cookedLevel;
+	// MaterialHash -> levelMaterials index, rebuilt on demand after a cooked load
+	std::unordered_multimap<unsigned long long, unsigned> materialLookup;
+	// optional 0-1 progress of the LoadLevel call in flight (may be on another thread)
+	std::atomic<float>* loadProgress = nullptr;
 public:
 	struct LEVEL_MODEL // one model in the level
 	{
 		const char* filename; // .h2b file data was pulled from
-		unsigned vertexCount, indexCount, materialCount, meshCount;
-		unsigned vertexStart, indexStart, materialStart, meshStart, batchStart;
-		unsigned colliderIndex; // *NEW* location of OBB in levelColliders
+		unsigned vertexCount, indexCount, materialCount, meshCount; // indexCount includes any LOD ranges
+		unsigned vertexStart, indexStart, meshStart, batchStart;
+		unsigned materialStart; // in levelMaterialIds, the model's own material slots
+		unsigned colliderIndex; // *NEW* location of OBB in levelColliders (model space, from levelModelBounds)
+		VertexPacking::BOUNDS vertexBounds; // model space AABB, also the packed vertex range
+		unsigned indexFormat; // bytes per index in levelIndexBuffer, 2 when every index fits in 16 bits
+		unsigned indexByteOffset; // where this model's indices start in levelIndexBuffer
 	};
 	struct MODEL_INSTANCES // each instance of a model in the level
 	{
@@ -25,6 +54,14 @@ public:
 	{
 		unsigned int albedoIndex, roughnessIndex, metalIndex, normalIndex;
 	};
+	struct MESHLET_RANGE // meshlets of one mesh in levelMeshlets
+	{
+		unsigned meshletCount, meshletStart;
+	};
+	struct LOD_RANGE // levels of detail of one mesh in levelMeshLods, finest first
+	{
+		unsigned lodCount, lodStart;
+	};
 	struct BLENDER_OBJECT // *NEW* Used to track individual objects in blender
 	{
 		const char* blendername; // *NEW* name of model straight from blender (FLECS)
@@ -32,9 +69,19 @@ public:
 	};
 	// All geometry data combined for level to be loaded onto the video card
 	std::vector<H2B::VERTEX> levelVertices;
+	// same vertices in the 16 byte format, only filled when settings.packVertices is on
+	std::vector<VertexPacking::PACKED_VERTEX> levelPackedVertices;
 	std::vector<unsigned> levelIndices;
-	// All material data used by the level
+	// GPU copy of levelIndices narrowed to 16 bits per model where possible,
+	// only filled when settings.narrowIndices is on
+	std::vector<unsigned char> levelIndexBuffer;
+	// Every distinct material used by the level, models sharing one (same ATTRIBUTES
+	// and texture names, see InternMaterial) share its entry
 	std::vector<H2B::MATERIAL> levelMaterials;
+	// levelMaterials index of each model's material slots (LEVEL_MODEL::materialStart,
+	// lines up with levelBatches) and of every mesh (same size as levelMeshes)
+	std::vector<unsigned> levelMaterialIds;
+	std::vector<unsigned> levelMeshMaterials;
 	// This could be populated by the Level_Renderer during GPU transfer
 	std::vector<MATERIAL_TEXTURES> levelTextures; // same size as LevelMaterials
 	// All transform data used by each model
@@ -44,14 +91,205 @@ public:
 	// All required drawing information combined
 	std::vector<H2B::BATCH> levelBatches;
 	std::vector<H2B::MESH> levelMeshes;
+	// culling clusters of every mesh, only filled when settings.buildMeshlets is on
+	std::vector<MeshOptimizer::MESHLET> levelMeshlets;
+	std::vector<MESHLET_RANGE> levelMeshletRanges; // same size as levelMeshes
+	// simplified index ranges of every mesh (the first one is the mesh itself),
+	// only filled when settings.generateLods is on
+	std::vector<MeshOptimizer::MESH_LOD> levelMeshLods;
+	std::vector<LOD_RANGE> levelMeshLodRanges; // same size as levelMeshes
+	// model space boxes & spheres of every mesh (its own index range) and whole model
+	std::vector<Bounds::VOLUME> levelMeshBounds; // same size as levelMeshes
+	std::vector<Bounds::VOLUME> levelModelBounds; // same size as levelModels
+	// levelModels index whose vertex & index ranges each mesh draws from (its drawInfo,
+	// meshlets & LODs are relative to that model), see ShareLevelGeometry. Same size
+	// as levelMeshes, or empty when every mesh draws its own model's geometry.
+	std::vector<unsigned> levelMeshGeometry;
+	// world space box & sphere of every instance, same size as levelTransforms
+	std::vector<Bounds::VOLUME> levelInstanceBounds;
 	std::vector<LEVEL_MODEL> levelModels;
 	// what we actually draw once loaded (using GPU instancing)
 	std::vector<MODEL_INSTANCES> levelInstances;
 	// *NEW* each item from the blender scene graph
 	std::vector<BLENDER_OBJECT> blenderObjects;
 
+	struct LOAD_SETTINGS // how LoadLevel imports and processes the level
+	{
+		bool parallelImport = true; // map & copy .h2b files on worker threads
+		bool batchedReads = true; // parallel import reads all loose .h2b files as one batch (io_uring on Linux)
+		bool hugePages = false; // back the big level arrays with 2 MB pages where the OS allows it (Linux)
+		bool useCookedLevels = true; // read/write a .lvlbin next to the level txt
+		bool packVertices = false; // also build levelPackedVertices for the GPU
+		bool narrowIndices = true; // build levelIndexBuffer with 16 bit indices where they fit
+		bool weldVertices = true; // merge duplicate vertices of each model
+		float weldEpsilon = 0.0f; // largest difference per component still welded, 0 = bit identical
+		bool optimizeVertexCache = true; // reorder triangles & vertices of each model for the GPU caches
+		bool optimizeOverdraw = false; // also sort the triangle clusters of opaque meshes outside-in
+		float overdrawThreshold = 1.05f; // ACMR the overdraw sort may trade away, 1.0 = none
+		bool reportOverdraw = false; // log a CPU estimate of each model's overdraw (slow, offline use)
+		bool buildMeshlets = true; // split meshes into levelMeshlets for per cluster culling
+		unsigned meshletMaxVertices = 64;
+		unsigned meshletMaxTriangles = 124;
+		bool generateLods = true; // append simplified index ranges to every mesh
+		unsigned lodCount = 4; // levels per mesh including the original, each halves the triangles
+		bool logLevelObjects = false; // log every MESH found in the level txt (slow on big levels)
+		ModelCache* modelCache = nullptr; // optional, reuses processed models across loads (not owned)
+		bool shareGeometry = true; // meshes identical to one of another model draw from its ranges
+		bool compressCooked = true; // write the geometry arrays of .lvlbin files block compressed
+		unsigned cookedBlockSize = BlockCompression::DEFAULT_BLOCK_SIZE; // 64 - 256 KB
+	};
+	LOAD_SETTINGS settings;
+
 	// Imports the default level txt format and collects all .h2b data
+	// Safe to call from a worker thread as long as nothing else touches this instance,
+	// "progress" (optional) is updated from 0 to 1 as the load advances.
 	bool LoadLevel(const char* gameLevelPath,
+		const char* h2bFolderPath,
+		GW::SYSTEM::GLog log,
+		std::atomic<float>* progress = nullptr) {
+		loadProgress = progress;
+		bool loaded = LoadLevelData(gameLevelPath, h2bFolderPath, log);
+		ReportProgress(1.0f);
+		loadProgress = nullptr;
+		return loaded;
+	}
+	// used to wipe CPU level data between levels, the memory goes back as well since
+	// the next level reserves its own exact sizes
+	void UnloadLevel() {
+		level_strings.Clear();
+		Release(levelVertices);
+		Release(levelPackedVertices);
+		Release(levelIndices);
+		Release(levelIndexBuffer);
+		Release(levelMaterials);
+		Release(levelMaterialIds);
+		Release(levelMeshMaterials);
+		materialLookup.clear();
+		Release(levelTextures);
+		Release(levelBatches);
+		Release(levelMeshes);
+		Release(levelMeshlets);
+		Release(levelMeshletRanges);
+		Release(levelMeshLods);
+		Release(levelMeshLodRanges);
+		Release(levelMeshBounds);
+		Release(levelModelBounds);
+		Release(levelMeshGeometry);
+		Release(levelInstanceBounds);
+		Release(levelModels);
+		Release(levelTransforms);
+		Release(levelColliders);
+		Release(levelInstances);
+		Release(blenderObjects);
+		cookedLevel.Close(); // after everything pointing into it is gone
+	}
+	// *HOT RELOAD*
+	// What a hot reload rewrote, so only those bytes go back to the GPU. Geometry that
+	// doesn't fit its old range is appended, the ranges can then end past the GPU buffers.
+	struct LEVEL_PATCH
+	{
+		size_t vertexStart = 0, vertexCount = 0; // levelVertices (or levelPackedVertices) elements
+		size_t indexByteStart = 0, indexByteCount = 0; // bytes of levelIndexBuffer (or levelIndices)
+		bool instancesChanged = false; // levelTransforms, levelInstances & blenderObjects were rebuilt
+		bool Empty() const { return vertexCount == 0 && indexByteCount == 0 && instancesChanged == false; }
+		void AddVertices(size_t start, size_t count) { Merge(vertexStart, vertexCount, start, count); }
+		void AddIndexBytes(size_t start, size_t count) { Merge(indexByteStart, indexByteCount, start, count); }
+	private:
+		static void Merge(size_t& start, size_t& count, size_t addStart, size_t addCount) {
+			if (addCount == 0)
+				return;
+			size_t end = (count == 0) ? addStart + addCount : std::max(start + count, addStart + addCount);
+			start = (count == 0) ? addStart : std::min(start, addStart);
+			count = end - start;
+		}
+	};
+	// Re-imports one .h2b ("Arch.h2b") and writes it over its ranges of the loaded level.
+	// False when the level doesn't use the model or it can't be read, nothing changes then.
+	// Cost is one model's import & processing, not the level's.
+	bool ReloadModel(const char* h2bFolderPath, const char* modelFile,
+		GW::SYSTEM::GLog log, LEVEL_PATCH& patch) {
+		auto start = std::chrono::steady_clock::now();
+		const size_t modelIndex = FindModel(modelFile);
+		if (modelIndex == levelModels.size())
+			return false;
+		auto data = ImportModel(h2bFolderPath, modelFile, log);
+		if (data == nullptr)
+			return false;
+		// models drawing some meshes from this one's ranges get their own copy back first
+		for (size_t b = 0; b < levelModels.size() && levelMeshGeometry.empty() == false; ++b) {
+			const LEVEL_MODEL& borrower = levelModels[b];
+			bool borrows = false;
+			for (unsigned j = 0; j < borrower.meshCount && b != modelIndex; ++j)
+				borrows = borrows || levelMeshGeometry[borrower.meshStart + j] == modelIndex;
+			if (borrows)
+				if (auto own = ImportModel(h2bFolderPath, borrower.filename, log))
+					ReplaceModel(b, *own, patch);
+		}
+		ReplaceModel(modelIndex, *data, patch);
+		for (auto& set : levelInstances)
+			if (set.modelIndex == modelIndex)
+				Bounds::TransformVolumes(levelModelBounds[modelIndex], levelTransforms[set.transformStart].data,
+					set.transformCount, &levelInstanceBounds[set.transformStart]);
+		UpdateCollider(modelIndex);
+		log.LogCategorized("EVENT", ("Hot reloaded " + std::string(modelFile) + ", " +
+			std::to_string(data->vertices.size()) + " vertices " + std::to_string(data->indices.size()) +
+			" indices in " + std::to_string(std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count()) + " ms").c_str());
+		return true;
+	}
+	// Re-reads the level layout and rebuilds every instance. Models already loaded are
+	// reused and only ones the level didn't use before are imported; models left without
+	// instances stay resident (and undrawn) until the next full load.
+	bool ReloadLayout(const char* gameLevelPath, const char* h2bFolderPath,
+		GW::SYSTEM::GLog log, LEVEL_PATCH& patch) {
+		auto start = std::chrono::steady_clock::now();
+		std::set<MODEL_ENTRY> uniqueModels;
+		bool read = LevelLayout::HasExtension(gameLevelPath) ?
+			ReadBinaryLevel(gameLevelPath, uniqueModels, log) :
+			ReadGameLevel(gameLevelPath, uniqueModels, log);
+		if (read == false)
+			return false; // keep what is on screen
+		levelTransforms.clear();
+		levelInstances.clear();
+		blenderObjects.clear();
+		size_t imported = 0;
+		for (auto& entry : uniqueModels) {
+			size_t modelIndex = FindModel(entry.modelFile.c_str());
+			if (modelIndex == levelModels.size()) {
+				auto data = ImportModel(h2bFolderPath, entry.modelFile, log);
+				if (data == nullptr)
+					continue; // reported by the import
+				LEVEL_MODEL model = {}; // empty ranges, so ReplaceModel appends everything
+				model.filename = level_strings.InternString(entry.modelFile);
+				model.indexFormat = 4;
+				model.colliderIndex = levelColliders.size();
+				levelColliders.push_back({});
+				levelModels.push_back(model);
+				levelModelBounds.push_back({});
+				ReplaceModel(modelIndex, *data, patch);
+				++imported;
+			}
+			RecordInstances(entry, static_cast<unsigned>(modelIndex));
+		}
+		ComputeInstanceBounds(log);
+		patch.instancesChanged = true;
+		log.LogCategorized("EVENT", ("Hot reloaded layout " + std::string(gameLevelPath) + ", " +
+			std::to_string(levelTransforms.size()) + " instances, " + std::to_string(imported) +
+			" new models in " + std::to_string(std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count()) + " ms").c_str());
+		return true;
+	}
+	// *NO RENDERING/GPU/DRAW LOGIC IN HERE PLEASE* 
+	// *DATA ORIENTED SHOULD AIM TO SEPERATE DATA FROM THE LOGIC THAT USES IT*
+	// The Level Renderer class is a good place to utilize this data.
+	// You can use your chosen API to have one GPU buffer for each type of data.
+	// Then you loop through instances using the API features to draw each mesh only once.
+private:
+	void ReportProgress(float done) {
+		if (loadProgress != nullptr)
+			loadProgress->store(done);
+	}
+	bool LoadLevelData(const char* gameLevelPath,
 		const char* h2bFolderPath,
 		GW::SYSTEM::GLog log) {
 		// What this does:
@@ -62,221 +300,1726 @@ public:
 			// if already encountered, just add its transfrom to the existing model entry.
 		// when finished, traverse model entries to import each model's data to the class.
 		std::set<MODEL_ENTRY> uniqueModels; // unique models and their locations
+		std::vector<const void*> reservedArrays; // where the import reserved, to catch regrowth
 		log.LogCategorized("EVENT", "LOADING GAME LEVEL [DATA ORIENTED]");
 
 		UnloadLevel();// clear previous level data if there is any
-		if (ReadGameLevel(gameLevelPath, uniqueModels, log) == false) {
+		const std::string cookedPath = CookedLevelPath(gameLevelPath);
+		if (settings.useCookedLevels && ReadCookedLevel(cookedPath.c_str(), log)) {
+			log.LogCategorized("EVENT", "GAME LEVEL WAS LOADED TO CPU FROM COOKED DATA [DATA ORIENTED]");
+			return true;
+		}
+		bool read = LevelLayout::HasExtension(gameLevelPath) ? // binary layout or exporter text
+			ReadBinaryLevel(gameLevelPath, uniqueModels, log) :
+			ReadGameLevel(gameLevelPath, uniqueModels, log);
+		if (read == false) {
 			log.LogCategorized("ERROR", "Fatal error reading game level, aborting level load.");
 			return false;
 		}
-		if (ReadAndCombineH2Bs(h2bFolderPath, uniqueModels, log) == false) {
-			log.LogCategorized("ERROR", "Fatal error combining H2B mesh data, aborting level load.");
-			return false;
+		ReportProgress(0.1f);
+		if (settings.modelCache != nullptr) {
+			if (CombineCachedModels(h2bFolderPath, uniqueModels, log) == false) {
+				log.LogCategorized("ERROR", "Fatal error combining H2B mesh data, aborting level load.");
+				return false;
+			}
+		}
+		else {
+			if (ReadAndCombineH2Bs(h2bFolderPath, uniqueModels, reservedArrays, log) == false) {
+				log.LogCategorized("ERROR", "Fatal error combining H2B mesh data, aborting level load.");
+				return false;
+			}
+			ProcessLevelGeometry(log);
 		}
+		if (settings.shareGeometry)
+			ShareLevelGeometry(log);
+		if (reservedArrays.empty() == false) // every pass works inside what SizeFromHeaders reserved
+			log.LogCategorized("INFO", ("Level arrays regrown by the import & processing passes: " +
+				std::to_string(CountRegrown(reservedArrays))).c_str());
+		ReportMaterials(log);
+		ComputeInstanceBounds(log);
+		if (settings.useCookedLevels) // next load of this level can skip all parsing
+			WriteCookedLevel(cookedPath.c_str(),
+				CookedLevelInputs(gameLevelPath, h2bFolderPath, uniqueModels), log);
 		// level loaded into CPU ram
 		log.LogCategorized("EVENT", "GAME LEVEL WAS LOADED TO CPU [DATA ORIENTED]");
 		return true;
 	}
-	// used to wipe CPU level data between levels
-	void UnloadLevel() {
-		level_strings.clear();
-		levelVertices.clear();
-		levelIndices.clear();
-		levelMaterials.clear();
-		levelTextures.clear();
-		levelBatches.clear();
-		levelMeshes.clear();
-		levelModels.clear();
-		levelTransforms.clear();
-		levelInstances.clear();
-		blenderObjects.clear();
+	// derived geometry data built once all models are combined
+	void ProcessLevelGeometry(GW::SYSTEM::GLog log) {
+		// welding and reordering must come first, everything below depends on the vertex & index order
+		if (settings.weldVertices)
+			WeldLevelVertices(log);
+		if (settings.optimizeVertexCache || settings.optimizeOverdraw || settings.reportOverdraw)
+			OptimizeLevelDrawOrder(log);
+		if (settings.generateLods)
+			GenerateLevelLods(log);
+		ComputeLevelBounds(log);
+		if (settings.packVertices)
+			PackLevelVertices(log);
+		if (settings.buildMeshlets)
+			BuildLevelMeshlets(log);
+		if (settings.narrowIndices)
+			NarrowLevelIndices(log);
+		ReportProgress(0.95f);
+	}
+	// model space volumes of every mesh and model, from the final vertices
+	void ComputeLevelBounds(GW::SYSTEM::GLog log) {
+		auto start = std::chrono::steady_clock::now();
+		levelMeshBounds.resize(levelMeshes.size());
+		levelModelBounds.resize(levelModels.size());
+		ParallelFor(levelModels.size(), [&](size_t i) {
+			LEVEL_MODEL& m = levelModels[i];
+			const H2B::VERTEX* vertices = &levelVertices[m.vertexStart];
+			const Bounds::VOLUME& model = levelModelBounds[i] = Bounds::FromVertices(vertices, m.vertexCount);
+			m.vertexBounds = { { model.min[0], model.min[1], model.min[2] },
+				{ model.max[0] - model.min[0], model.max[1] - model.min[1], model.max[2] - model.min[2] } };
+			for (unsigned j = 0; j < m.meshCount; ++j) {
+				const H2B::BATCH& draw = levelMeshes[m.meshStart + j].drawInfo;
+				levelMeshBounds[m.meshStart + j] = Bounds::FromIndices(vertices,
+					&levelIndices[m.indexStart + draw.indexOffset], draw.indexCount);
+			}
+		});
+		log.LogCategorized("INFO", ("Bounds of " + std::to_string(levelMeshes.size()) + " meshes & " +
+			std::to_string(levelModels.size()) + " models (" + std::to_string(levelVertices.size()) + " vertices) in " +
+			std::to_string(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) +
+			" ms").c_str());
+	}
+	// world space volumes of every instance & the model colliders, after the level is assembled
+	void ComputeInstanceBounds(GW::SYSTEM::GLog log) {
+		auto start = std::chrono::steady_clock::now();
+		levelInstanceBounds.resize(levelTransforms.size());
+		ParallelFor(levelInstances.size(), [&](size_t i) {
+			const MODEL_INSTANCES& set = levelInstances[i];
+			Bounds::TransformVolumes(levelModelBounds[set.modelIndex], levelTransforms[set.transformStart].data,
+				set.transformCount, &levelInstanceBounds[set.transformStart]);
+		});
+		for (size_t i = 0; i < levelModels.size(); ++i)
+			UpdateCollider(i);
+		log.LogCategorized("INFO", ("World bounds of " + std::to_string(levelTransforms.size()) + " instances in " +
+			std::to_string(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) +
+			" ms").c_str());
+	}
+	void UpdateCollider(size_t modelIndex) {
+		const Bounds::VOLUME& b = levelModelBounds[modelIndex];
+		GW::MATH::GOBBF& obb = levelColliders[levelModels[modelIndex].colliderIndex];
+		obb.center = { (b.min[0] + b.max[0]) * 0.5f, (b.min[1] + b.max[1]) * 0.5f, (b.min[2] + b.max[2]) * 0.5f, 1.0f };
+		obb.extent = { (b.max[0] - b.min[0]) * 0.5f, (b.max[1] - b.min[1]) * 0.5f, (b.max[2] - b.min[2]) * 0.5f, 0.0f };
+		obb.rotation = GW::MATH::GIdentityQuaternionF; // local space, the instance transform places it
+	}
+	// welds each model on its own, then closes the gaps left in levelVertices
+	void WeldLevelVertices(GW::SYSTEM::GLog log) {
+		std::vector<unsigned> welded(levelModels.size());
+		ParallelFor(levelModels.size(), [&](size_t i) {
+			const LEVEL_MODEL& m = levelModels[i];
+			welded[i] = static_cast<unsigned>(MeshOptimizer::WeldVertices(&levelVertices[m.vertexStart],
+				m.vertexCount, &levelIndices[m.indexStart], m.indexCount, settings.weldEpsilon));
+		});
+		unsigned next = 0;
+		for (size_t i = 0; i < levelModels.size(); ++i) {
+			LEVEL_MODEL& m = levelModels[i];
+			log.LogCategorized("INFO", ("Welded " + std::string(m.filename) + " vertices " +
+				std::to_string(m.vertexCount) + " -> " + std::to_string(welded[i])).c_str());
+			std::copy(levelVertices.begin() + m.vertexStart, levelVertices.begin() + m.vertexStart + welded[i],
+				levelVertices.begin() + next); // only ever moves data towards the front
+			m.vertexStart = next;
+			m.vertexCount = welded[i];
+			next += welded[i];
+		}
+		log.LogCategorized("INFO", ("Level vertices welded " + std::to_string(levelVertices.size()) +
+			" -> " + std::to_string(next)).c_str());
+		levelVertices.resize(next); // keeps the sized allocation, the welded away tail is small
+	}
+	// Forsyth triangle order inside every mesh/batch range, optionally followed by an
+	// outside-in cluster sort of the opaque ranges, then a vertex renumbering in first use order.
+	// Draw ranges are never crossed so levelBatches and levelMeshes stay valid as is,
+	// only the contents of each range move.
+	void OptimizeLevelDrawOrder(GW::SYSTEM::GLog log) {
+		std::vector<MeshOptimizer::CACHE_STATS> before(levelModels.size()), after(levelModels.size());
+		std::vector<MeshOptimizer::OVERDRAW_STATS> overdrawBefore(levelModels.size()), overdrawAfter(levelModels.size());
+		ParallelFor(levelModels.size(), [&](size_t i) {
+			const LEVEL_MODEL& m = levelModels[i];
+			unsigned* indices = &levelIndices[m.indexStart];
+			const H2B::VERTEX* vertices = &levelVertices[m.vertexStart];
+			before[i] = MeshOptimizer::AnalyzeVertexCache(indices, m.indexCount, m.vertexCount);
+			if (settings.reportOverdraw)
+				overdrawBefore[i] = MeshOptimizer::EstimateOverdraw(vertices, m.vertexCount, indices, m.indexCount);
+			std::vector<H2B::BATCH> drawRanges(levelBatches.begin() + m.batchStart,
+				levelBatches.begin() + m.batchStart + m.materialCount);
+			for (unsigned j = 0; j < m.meshCount; ++j)
+				drawRanges.push_back(levelMeshes[m.meshStart + j].drawInfo);
+			auto ranges = MeshOptimizer::SplitDrawRanges(m.indexCount, drawRanges);
+			if (settings.optimizeVertexCache)
+				MeshOptimizer::OptimizeVertexCache(indices, m.vertexCount, ranges);
+			if (settings.optimizeOverdraw)
+				for (auto& r : ranges)
+					if (IsOpaqueRange(m, r.first))
+						MeshOptimizer::OptimizeOverdrawRange(indices + r.first, r.second,
+							vertices, m.vertexCount, settings.overdrawThreshold);
+			if (settings.optimizeVertexCache || settings.optimizeOverdraw)
+				MeshOptimizer::OptimizeVertexFetch(&levelVertices[m.vertexStart], m.vertexCount,
+					indices, m.indexCount);
+			after[i] = MeshOptimizer::AnalyzeVertexCache(indices, m.indexCount, m.vertexCount);
+			if (settings.reportOverdraw)
+				overdrawAfter[i] = MeshOptimizer::EstimateOverdraw(vertices, m.vertexCount, indices, m.indexCount);
+		});
+		for (size_t i = 0; i < levelModels.size(); ++i) {
+			log.LogCategorized("INFO", ("Vertex cache " + std::string(levelModels[i].filename) +
+				" ACMR " + std::to_string(before[i].acmr) + " -> " + std::to_string(after[i].acmr) +
+				" ATVR " + std::to_string(before[i].atvr) + " -> " + std::to_string(after[i].atvr)).c_str());
+			if (settings.reportOverdraw)
+				log.LogCategorized("INFO", ("Overdraw " + std::string(levelModels[i].filename) +
+					" " + std::to_string(overdrawBefore[i].overdraw) + " -> " +
+					std::to_string(overdrawAfter[i].overdraw) + " pixels shaded per covered pixel").c_str());
+		}
+	}
+	// blended materials have to keep their authored order
+	bool IsOpaqueRange(const LEVEL_MODEL& m, unsigned indexOffset) const {
+		for (unsigned j = 0; j < m.meshCount; ++j) {
+			const H2B::MESH& mesh = levelMeshes[m.meshStart + j];
+			if (indexOffset < mesh.drawInfo.indexOffset ||
+				indexOffset >= mesh.drawInfo.indexOffset + mesh.drawInfo.indexCount)
+				continue;
+			const H2B::MATERIAL& mat = levelMaterials[levelMeshMaterials[m.meshStart + j]];
+			return mat.attrib.d >= 1.0f && (mat.map_d == nullptr || mat.map_d[0] == '\0');
+		}
+		return false;
+	}
+	// Simplifies every mesh from its original triangles to 1/2, 1/4 ... of them and appends
+	// the results behind the model's own indices, so offsets stay relative to the model
+	// and models after it move back. Meshes that can't be reduced further repeat their last level.
+	// Expects the models' index ranges in model order, as every import lays them out.
+	void GenerateLevelLods(GW::SYSTEM::GLog log) {
+		const unsigned levels = std::max(1u, settings.lodCount);
+		std::vector<std::vector<unsigned>> extra(levelModels.size());
+		std::vector<MeshOptimizer::MESH_LOD> lods(levelMeshes.size() * levels);
+		ParallelFor(levelModels.size(), [&](size_t i) {
+			const LEVEL_MODEL& m = levelModels[i];
+			const H2B::VERTEX* vertices = &levelVertices[m.vertexStart];
+			const unsigned* indices = &levelIndices[m.indexStart];
+			std::vector<int> scratch(m.vertexCount, -1);
+			for (unsigned j = 0; j < m.meshCount; ++j) {
+				const H2B::BATCH& draw = levelMeshes[m.meshStart + j].drawInfo;
+				MeshOptimizer::MESH_LOD* out = &lods[(m.meshStart + j) * levels];
+				out[0] = { draw.indexCount, draw.indexOffset, 0.0f };
+				for (unsigned l = 1; l < levels; ++l) {
+					size_t target = (static_cast<size_t>(draw.indexCount) >> l) / 3 * 3;
+					float error = 0.0f;
+					std::vector<unsigned> simple = MeshOptimizer::SimplifyMesh(vertices, m.vertexCount,
+						indices + draw.indexOffset, draw.indexCount, target, error);
+					if (simple.size() >= out[l - 1].indexCount) { // stuck, reuse the previous level
+						out[l] = out[l - 1];
+						continue;
+					}
+					MeshOptimizer::OptimizeVertexCacheRange(simple.data(), simple.size(), scratch);
+					out[l] = { static_cast<unsigned>(simple.size()),
+						static_cast<unsigned>(m.indexCount + extra[i].size()), std::max(error, out[l - 1].error) };
+					extra[i].insert(extra[i].end(), simple.begin(), simple.end());
+				}
+			}
+		});
+		// grow levelIndices in place (SizeFromHeaders reserved for the LODs) and put every
+		// model's levels right behind it, from the last model back so nothing unmoved is overwritten
+		size_t total = levelIndices.size();
+		for (auto& e : extra)
+			total += e.size();
+		levelIndices.resize(total);
+		size_t end = total;
+		for (size_t i = levelModels.size(); i-- > 0;) {
+			LEVEL_MODEL& m = levelModels[i];
+			const size_t newStart = end - m.indexCount - extra[i].size();
+			std::copy_backward(levelIndices.begin() + m.indexStart, levelIndices.begin() + m.indexStart + m.indexCount,
+				levelIndices.begin() + newStart + m.indexCount);
+			std::copy(extra[i].begin(), extra[i].end(), levelIndices.begin() + newStart + m.indexCount);
+			m.indexStart = static_cast<unsigned>(newStart);
+			end = newStart;
+		}
+		size_t original = 0, simplified = 0;
+		for (size_t i = 0; i < levelModels.size(); ++i) {
+			LEVEL_MODEL& m = levelModels[i];
+			std::string report = "LODs " + std::string(m.filename) + " triangles";
+			for (unsigned l = 0; l < levels; ++l) {
+				unsigned count = 0;
+				float error = 0.0f;
+				for (unsigned j = 0; j < m.meshCount; ++j) {
+					count += lods[(m.meshStart + j) * levels + l].indexCount / 3;
+					error = std::max(error, lods[(m.meshStart + j) * levels + l].error);
+				}
+				report += " " + std::to_string(count) + " (" + std::to_string(error) + ")";
+			}
+			log.LogCategorized("INFO", report.c_str());
+			original += m.indexCount;
+			simplified += extra[i].size();
+			m.indexCount += static_cast<unsigned>(extra[i].size());
+		}
+		levelMeshLods.swap(lods);
+		levelMeshLodRanges.resize(levelMeshes.size());
+		for (size_t j = 0; j < levelMeshes.size(); ++j)
+			levelMeshLodRanges[j] = { levels, static_cast<unsigned>(j * levels) };
+		log.LogCategorized("INFO", ("Level of detail indices: " + std::to_string(simplified) +
+			" on top of " + std::to_string(original)).c_str());
+	}
+	// meshlets only split the final index order, so this runs after every reordering pass
+	void BuildLevelMeshlets(GW::SYSTEM::GLog log) {
+		std::vector<std::vector<MeshOptimizer::MESHLET>> perMesh(levelMeshes.size());
+		ParallelFor(levelModels.size(), [&](size_t i) {
+			const LEVEL_MODEL& m = levelModels[i];
+			std::vector<unsigned> scratch(m.vertexCount, ~0u);
+			for (unsigned j = 0; j < m.meshCount; ++j) {
+				const H2B::BATCH& draw = levelMeshes[m.meshStart + j].drawInfo;
+				MeshOptimizer::BuildMeshlets(&levelVertices[m.vertexStart], &levelIndices[m.indexStart],
+					draw.indexOffset, draw.indexCount, scratch, perMesh[m.meshStart + j],
+					settings.meshletMaxVertices, settings.meshletMaxTriangles);
+			}
+		});
+		levelMeshletRanges.resize(levelMeshes.size());
+		size_t total = 0, cullable = 0;
+		for (size_t i = 0; i < perMesh.size(); ++i) {
+			levelMeshletRanges[i] = { static_cast<unsigned>(perMesh[i].size()), static_cast<unsigned>(total) };
+			total += perMesh[i].size();
+		}
+		levelMeshlets.reserve(total);
+		for (auto& meshlets : perMesh)
+			for (auto& meshlet : meshlets) {
+				cullable += (meshlet.coneCutoff <= 1.0f) ? 1 : 0;
+				levelMeshlets.push_back(meshlet);
+			}
+		log.LogCategorized("INFO", ("Built " + std::to_string(total) + " meshlets for " +
+			std::to_string(levelMeshes.size()) + " meshes, " + std::to_string(cullable) +
+			" with a usable normal cone").c_str());
+	}
+	// indices are relative to each model's vertexStart, so any model with
+	// 65536 vertices or less can be drawn from a 16 bit range of the buffer
+	void NarrowLevelIndices(GW::SYSTEM::GLog log) {
+		size_t bytes = 0;
+		for (auto& m : levelModels) {
+			m.indexFormat = (m.vertexCount <= 65536) ? 2 : 4;
+			m.indexByteOffset = static_cast<unsigned>(bytes);
+			bytes += (m.indexCount * m.indexFormat + 3) & ~size_t(3); // keep every range 4 byte aligned
+		}
+		levelIndexBuffer.assign(bytes, 0);
+		ParallelFor(levelModels.size(), [&](size_t i) {
+			const LEVEL_MODEL& m = levelModels[i];
+			const unsigned* first = &levelIndices[m.indexStart];
+			unsigned char* out = &levelIndexBuffer[m.indexByteOffset];
+			if (m.indexFormat == 2) {
+				for (unsigned j = 0; j < m.indexCount; ++j) {
+					uint16_t narrow = static_cast<uint16_t>(first[j]);
+					std::memcpy(out + j * 2, &narrow, 2);
+				}
+			}
+			else
+				std::memcpy(out, first, m.indexCount * 4);
+		});
+		log.LogCategorized("INFO", ("Index buffer narrowed " + std::to_string(levelIndices.size() * 4) +
+			" -> " + std::to_string(levelIndexBuffer.size()) + " bytes").c_str());
+	}
+	// Every mesh whose triangles (all of its LODs) match a mesh of another model, compared
+	// through the vertices they point at, drops its own copy and draws from that model's
+	// ranges instead (levelMeshGeometry). Catches assets exported twice under different
+	// names. Runs on the assembled level, cached & cooked models always stay whole.
+	void ShareLevelGeometry(GW::SYSTEM::GLog log) {
+		auto start = std::chrono::steady_clock::now();
+		const size_t meshCount = levelMeshes.size();
+		std::vector<unsigned> owner(meshCount);
+		for (unsigned i = 0; i < levelModels.size(); ++i)
+			for (unsigned j = 0; j < levelModels[i].meshCount; ++j)
+				owner[levelModels[i].meshStart + j] = i;
+		// index ranges a mesh is drawn with, relative to its model
+		auto forEachRange = [&](size_t g, auto&& visit) {
+			if (levelMeshLodRanges.empty()) {
+				visit(levelMeshes[g].drawInfo.indexOffset, levelMeshes[g].drawInfo.indexCount);
+				return;
+			}
+			const LOD_RANGE& r = levelMeshLodRanges[g];
+			for (unsigned l = 0; l < r.lodCount; ++l)
+				visit(levelMeshLods[r.lodStart + l].indexOffset, levelMeshLods[r.lodStart + l].indexCount);
+		};
+		auto vertexAt = [&](size_t g, unsigned index) -> const H2B::VERTEX& {
+			const LEVEL_MODEL& m = levelModels[owner[g]];
+			return levelVertices[m.vertexStart + levelIndices[m.indexStart + index]];
+		};
+		std::vector<unsigned long long> hashes(meshCount);
+		ParallelFor(meshCount, [&](size_t g) {
+			unsigned long long hash = HashBytes(nullptr, 0);
+			forEachRange(g, [&](unsigned offset, unsigned count) {
+				hash = HashBytes(&count, sizeof(count), hash);
+				for (unsigned k = 0; k < count; ++k)
+					hash = HashBytes(&vertexAt(g, offset + k), sizeof(H2B::VERTEX), hash);
+			});
+			hashes[g] = hash;
+		});
+		auto sameGeometry = [&](size_t a, size_t b) {
+			std::vector<std::pair<unsigned, unsigned>> ra, rb;
+			forEachRange(a, [&](unsigned offset, unsigned count) { ra.push_back({ offset, count }); });
+			forEachRange(b, [&](unsigned offset, unsigned count) { rb.push_back({ offset, count }); });
+			if (ra.size() != rb.size())
+				return false;
+			for (size_t l = 0; l < ra.size(); ++l) {
+				if (ra[l].second != rb[l].second)
+					return false;
+				for (unsigned k = 0; k < ra[l].second; ++k)
+					if (std::memcmp(&vertexAt(a, ra[l].first + k), &vertexAt(b, rb[l].first + k), sizeof(H2B::VERTEX)) != 0)
+						return false;
+			}
+			return true;
+		};
+		// the first mesh with some geometry keeps it, later ones in other models share it
+		std::vector<unsigned> source(meshCount);
+		std::unordered_multimap<unsigned long long, unsigned> first;
+		size_t shared = 0;
+		for (unsigned g = 0; g < meshCount; ++g) {
+			source[g] = g;
+			if (levelMeshes[g].drawInfo.indexCount == 0)
+				continue;
+			auto range = first.equal_range(hashes[g]);
+			for (auto i = range.first; i != range.second && source[g] == g; ++i)
+				if (owner[i->second] != owner[g] && sameGeometry(i->second, g))
+					source[g] = i->second;
+			if (source[g] == g)
+				first.emplace(hashes[g], g);
+			else
+				++shared;
+		}
+		if (shared == 0) {
+			log.LogCategorized("INFO", "Shared geometry: every mesh is unique");
+			return;
+		}
+		// compact the geometry arrays in place without the shared copies, model by model. Models,
+		// meshlets and LODs lie in model order, so every write lands at or before what it copies.
+		const bool packed = levelPackedVertices.empty() == false;
+		const bool narrowed = levelIndexBuffer.empty() == false;
+		const size_t vertexBytes = levelVertices.size() * sizeof(H2B::VERTEX) +
+			levelPackedVertices.size() * sizeof(VertexPacking::PACKED_VERTEX);
+		const size_t indexBytes = levelIndices.size() * sizeof(unsigned) + levelIndexBuffer.size();
+		size_t vertices = 0, indices = 0, bufferBytes = 0, meshlets = 0, lods = 0; // compacted so far
+		for (LEVEL_MODEL& m : levelModels) {
+			std::vector<char> keep(m.indexCount, 1);
+			for (unsigned j = 0; j < m.meshCount; ++j)
+				if (source[m.meshStart + j] != m.meshStart + j)
+					forEachRange(m.meshStart + j, [&](unsigned offset, unsigned count) {
+						std::fill(keep.begin() + offset, keep.begin() + offset + count, 0); });
+			std::vector<unsigned> newOffset(m.indexCount + 1, 0); // kept indices before each one
+			for (unsigned k = 0; k < m.indexCount; ++k)
+				newOffset[k + 1] = newOffset[k] + keep[k];
+			// vertices only the removed ranges use go, unreferenced ones stay like before
+			std::vector<char> usedKept(m.vertexCount, 0), usedRemoved(m.vertexCount, 0);
+			for (unsigned k = 0; k < m.indexCount; ++k)
+				(keep[k] ? usedKept : usedRemoved)[levelIndices[m.indexStart + k]] = 1;
+			std::vector<unsigned> newVertex(m.vertexCount, ~0u);
+			const size_t vertexStart = vertices;
+			for (unsigned v = 0; v < m.vertexCount; ++v) {
+				if (usedRemoved[v] && usedKept[v] == false)
+					continue;
+				newVertex[v] = static_cast<unsigned>(vertices - vertexStart);
+				levelVertices[vertices] = levelVertices[m.vertexStart + v];
+				if (packed)
+					levelPackedVertices[vertices] = levelPackedVertices[m.vertexStart + v];
+				++vertices;
+			}
+			const size_t indexStart = indices;
+			for (unsigned k = 0; k < m.indexCount; ++k)
+				if (keep[k])
+					levelIndices[indices++] = newVertex[levelIndices[m.indexStart + k]];
+			auto move = [&](unsigned& offset, unsigned& count) {
+				const unsigned end = offset + count;
+				offset = newOffset[offset];
+				count = newOffset[end] - offset;
+			};
+			for (unsigned b = 0; b < m.materialCount; ++b)
+				move(levelBatches[m.batchStart + b].indexOffset, levelBatches[m.batchStart + b].indexCount);
+			for (unsigned j = 0; j < m.meshCount; ++j) {
+				const unsigned g = m.meshStart + j;
+				if (source[g] != g)
+					continue; // takes the source's ranges below
+				move(levelMeshes[g].drawInfo.indexOffset, levelMeshes[g].drawInfo.indexCount);
+				if (levelMeshletRanges.empty() == false) {
+					MESHLET_RANGE& r = levelMeshletRanges[g];
+					const unsigned meshletStart = static_cast<unsigned>(meshlets);
+					for (unsigned k = 0; k < r.meshletCount; ++k, ++meshlets) {
+						levelMeshlets[meshlets] = levelMeshlets[r.meshletStart + k];
+						levelMeshlets[meshlets].indexOffset = newOffset[levelMeshlets[meshlets].indexOffset];
+					}
+					r.meshletStart = meshletStart;
+				}
+				if (levelMeshLodRanges.empty() == false) {
+					LOD_RANGE& r = levelMeshLodRanges[g];
+					const unsigned lodStart = static_cast<unsigned>(lods);
+					for (unsigned l = 0; l < r.lodCount; ++l, ++lods) {
+						levelMeshLods[lods] = levelMeshLods[r.lodStart + l];
+						move(levelMeshLods[lods].indexOffset, levelMeshLods[lods].indexCount);
+					}
+					r.lodStart = lodStart;
+				}
+			}
+			if (narrowed) { // same format, the model only lost vertices
+				m.indexByteOffset = static_cast<unsigned>(bufferBytes);
+				for (size_t k = indexStart; k < indices; ++k) {
+					const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&levelIndices[k]);
+					uint16_t narrow = static_cast<uint16_t>(levelIndices[k]);
+					if (m.indexFormat == 2)
+						bytes = reinterpret_cast<const unsigned char*>(&narrow);
+					std::memcpy(&levelIndexBuffer[bufferBytes], bytes, m.indexFormat);
+					bufferBytes += m.indexFormat;
+				}
+				for (; bufferBytes % 4 != 0; ++bufferBytes)
+					levelIndexBuffer[bufferBytes] = 0;
+			}
+			m.vertexStart = static_cast<unsigned>(vertexStart);
+			m.vertexCount = static_cast<unsigned>(vertices - vertexStart);
+			m.indexStart = static_cast<unsigned>(indexStart);
+			m.indexCount = static_cast<unsigned>(indices - indexStart);
+		}
+		levelMeshGeometry.resize(meshCount);
+		for (unsigned g = 0; g < meshCount; ++g) {
+			levelMeshGeometry[g] = owner[source[g]];
+			if (source[g] == g)
+				continue;
+			levelMeshes[g].drawInfo = levelMeshes[source[g]].drawInfo;
+			if (levelMeshletRanges.empty() == false)
+				levelMeshletRanges[g] = levelMeshletRanges[source[g]];
+			if (levelMeshLodRanges.empty() == false)
+				levelMeshLodRanges[g] = levelMeshLodRanges[source[g]];
+		}
+		levelVertices.resize(vertices);
+		if (packed)
+			levelPackedVertices.resize(vertices);
+		levelIndices.resize(indices);
+		levelIndexBuffer.resize(bufferBytes);
+		if (levelMeshletRanges.empty() == false)
+			levelMeshlets.resize(meshlets);
+		if (levelMeshLodRanges.empty() == false)
+			levelMeshLods.resize(lods);
+		const size_t newVertexBytes = levelVertices.size() * sizeof(H2B::VERTEX) +
+			levelPackedVertices.size() * sizeof(VertexPacking::PACKED_VERTEX);
+		const size_t newIndexBytes = levelIndices.size() * sizeof(unsigned) + levelIndexBuffer.size();
+		log.LogCategorized("INFO", ("Shared geometry: " + std::to_string(shared) + " of " + std::to_string(meshCount) +
+			" meshes draw from an identical mesh of another model, vertex data " + std::to_string(vertexBytes) +
+			" -> " + std::to_string(newVertexBytes) + " bytes, index data " + std::to_string(indexBytes) + " -> " +
+			std::to_string(newIndexBytes) + " bytes (" + std::to_string((vertexBytes + indexBytes -
+				newVertexBytes - newIndexBytes) / 1024) + " KB saved) in " + std::to_string(std::chrono::duration<double,
+				std::milli>(std::chrono::steady_clock::now() - start).count()) + " ms").c_str());
+	}
+	// quantizes every model against its own bounds then checks the result
+	// by unpacking it again exactly like the vertex shader does
+	void PackLevelVertices(GW::SYSTEM::GLog log) {
+		levelPackedVertices.resize(levelVertices.size());
+		std::vector<VertexPacking::ROUND_TRIP_ERROR> errors(levelModels.size(), { 0, 0, 0, 0 });
+		ParallelFor(levelModels.size(), [&](size_t i) {
+			const LEVEL_MODEL& m = levelModels[i];
+			for (unsigned v = m.vertexStart; v < m.vertexStart + m.vertexCount; ++v)
+				levelPackedVertices[v] = VertexPacking::Pack(levelVertices[v], m.vertexBounds);
+			VertexPacking::MeasureRoundTrip(&levelVertices[m.vertexStart],
+				&levelPackedVertices[m.vertexStart], m.vertexCount, m.vertexBounds, errors[i]);
+		});
+		VertexPacking::ROUND_TRIP_ERROR worst = { 0, 0, 0, 0 };
+		for (auto& e : errors) {
+			worst.position = std::max(worst.position, e.position);
+			worst.positionRelative = std::max(worst.positionRelative, e.positionRelative);
+			worst.uv = std::max(worst.uv, e.uv);
+			worst.normalDegrees = std::max(worst.normalDegrees, e.normalDegrees);
+		}
+		log.LogCategorized("INFO", ("Packed " + std::to_string(levelVertices.size()) +
+			" vertices (" + std::to_string(levelVertices.size() * sizeof(H2B::VERTEX)) + " -> " +
+			std::to_string(levelPackedVertices.size() * sizeof(VertexPacking::PACKED_VERTEX)) +
+			" bytes), max round trip error: position " + std::to_string(worst.position) +
+			" (" + std::to_string(worst.positionRelative * 100.0f) + "% of extent) uv " +
+			std::to_string(worst.uv) + " normal " + std::to_string(worst.normalDegrees) + " deg").c_str());
 	}
-	// *NO RENDERING/GPU/DRAW LOGIC IN HERE PLEASE* 
-	// *DATA ORIENTED SHOULD AIM TO SEPERATE DATA FROM THE LOGIC THAT USES IT*
-	// The Level Renderer class is a good place to utilize this data.
-	// You can use your chosen API to have one GPU buffer for each type of data.
-	// Then you loop through instances using the API features to draw each mesh only once.
-private:
 	// internal defintion for reading the GameLevel layout 
 	struct MODEL_ENTRY
 	{
 		std::string modelFile; // path to .h2b file
-		// *NEW* object aligned bounding box data: // LBN, LTN, LTF, LBF, RBN, RTN, RTF, RBF
-		GW::MATH2D::GVECTOR3F boundry[8];
 		mutable std::vector<std::string> blenderNames; // *NEW* names from blender
 		mutable std::vector<GW::MATH::GMATRIXF> instances; // where to draw
 		bool operator<(const MODEL_ENTRY& cmp) const {
 			return modelFile < cmp.modelFile; // you need this for std::set to work
 		}
-		// *NEW* converts the vec3 boundries to an OBB
-		GW::MATH::GOBBF ComputeOBB() const {
-			GW::MATH::GOBBF out = {
-				GW::MATH::GIdentityVectorF,
-				GW::MATH::GIdentityVectorF,
-				GW::MATH::GIdentityQuaternionF // initally unrotated (local space)
-			};
-			out.center.x = (boundry[0].x + boundry[4].x) * 0.5f;
-			out.center.y = (boundry[0].y + boundry[1].y) * 0.5f;
-			out.center.z = (boundry[0].z + boundry[2].z) * 0.5f;
-			out.extent.x = std::fabsf(boundry[0].x - boundry[4].x) * 0.5f;
-			out.extent.y = std::fabsf(boundry[0].y - boundry[1].y) * 0.5f;
-			out.extent.z = std::fabsf(boundry[0].z - boundry[2].z) * 0.5f;
-			return out;
-		}
 	};
-	// internal helper for reading the game level
+	// internal helper for reading the game level, maps the file and scans it in one pass
 	bool ReadGameLevel(const char* gameLevelPath,
 		std::set<MODEL_ENTRY>& outModels,
 		GW::SYSTEM::GLog log) {
 		log.LogCategorized("MESSAGE", "Begin Reading Game Level Text File.");
-		GW::SYSTEM::GFile file;
-		file.Create();
-		if (-file.OpenTextRead(gameLevelPath)) {
+		auto start = std::chrono::steady_clock::now();
+		VirtualFile file;
+		if (file.Open(gameLevelPath) == false) {
 			log.LogCategorized(
 				"ERROR", (std::string("Game level not found: ") + gameLevelPath).c_str());
 			return false;
 		}
-		char linebuffer[1024];
-		while (+file.ReadLine(linebuffer, 1024, '\n'))
-		{
-			// having to have this is a bug, need to have Read/ReadLine return failure at EOF
-			if (linebuffer[0] == '\0')
-				break;
-			if (std::strcmp(linebuffer, "MESH") == 0)
-			{
-				file.ReadLine(linebuffer, 1024, '\n');
-				std::string blenderName = linebuffer;
-				log.LogCategorized("INFO", (std::string("Model Detected: ") + blenderName).c_str());
-				// create the model file name from this (strip the .001)
-				MODEL_ENTRY add = { linebuffer };
-				add.modelFile = add.modelFile.substr(0, add.modelFile.find_last_of("."));
-				add.modelFile += ".h2b";
-
-				// now read the transform data as we will need that regardless
+		// entries in file order, found by model name through a hash map whose keys
+		// point into the mapping so repeated models cost no allocation
+		std::vector<MODEL_ENTRY> entries;
+		std::unordered_map<std::string_view, size_t> lookup;
+		size_t meshCount = 0;
+		size_t malformed = GameLevelReader::ParseMeshes(reinterpret_cast<const char*>(file.Data()), file.Size(),
+			[&](std::string_view blenderName, const float (&matrix)[16]) {
 				GW::MATH::GMATRIXF transform;
-				for (int i = 0; i < 4; ++i) {
-					file.ReadLine(linebuffer, 1024, '\n');
-					// read floats
-					sscanf_s(linebuffer + 13, "%f, %f, %f, %f",
-						&transform.data[0 + i * 4], &transform.data[1 + i * 4],
-						&transform.data[2 + i * 4], &transform.data[3 + i * 4]);
+				std::memcpy(transform.data, matrix, sizeof(transform.data));
+				if (settings.logLevelObjects) {
+					log.LogCategorized("INFO", ("Model Detected: " + std::string(blenderName)).c_str());
+					log.LogCategorized("INFO", ("Location: X " + std::to_string(transform.row4.x) +
+						" Y " + std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z)).c_str());
 				}
-				std::string loc = "Location: X ";
-				loc += std::to_string(transform.row4.x) + " Y " +
-					std::to_string(transform.row4.y) + " Z " + std::to_string(transform.row4.z);
-				log.LogCategorized("INFO", loc.c_str());
-
-				//// *NEW* finally read in the boundry data for this model
-				//for (int i = 0; i < 8; ++i) {
-				//	file.ReadLine(linebuffer, 1024, '\n');
-				//	// read floats
-				//	std::sscanf(linebuffer + 9, "%f, %f, %f",
-				//		&add.boundry[i].x, &add.boundry[i].y, &add.boundry[i].z);
-				//}
-				//std::string bounds = "Boundry: Left ";
-				//bounds += std::to_string(add.boundry[0].x) +
-				//" Right " +	std::to_string(add.boundry[4].x) +
-				//" Bottom " + std::to_string(add.boundry[0].y) +
-				//" Top " + std::to_string(add.boundry[1].y) +
-				//" Near " + std::to_string(add.boundry[0].z) +
-				//" Far " + std::to_string(add.boundry[2].z);
-				//log.LogCategorized("INFO", bounds.c_str());
-
-				// does this model already exist?
-				auto found = outModels.find(add);
-				if (found == outModels.end()) // no
-				{
-					add.blenderNames.push_back(blenderName); // *NEW*
-					add.instances.push_back(transform);
-					outModels.insert(add);
-				}
-				else // yes
-				{
-					found->blenderNames.push_back(blenderName); // *NEW*
-					found->instances.push_back(transform);
+				// create the model file name from this (strip the .001)
+				std::string_view model = GameLevelReader::ModelName(blenderName);
+				auto found = lookup.find(model);
+				if (found == lookup.end()) {
+					found = lookup.emplace(model, entries.size()).first;
+					entries.emplace_back();
+					entries.back().modelFile.assign(model.data(), model.size()).append(".h2b");
 				}
-			}
+				MODEL_ENTRY& entry = entries[found->second];
+				entry.blenderNames.emplace_back(blenderName); // *NEW*
+				entry.instances.push_back(transform);
+				++meshCount;
+			});
+		if (malformed > 0)
+			log.LogCategorized("WARNING", (std::to_string(malformed) +
+				" malformed MESH block(s) skipped in " + gameLevelPath).c_str());
+		for (auto& e : entries)
+			outModels.insert(std::move(e));
+		log.LogCategorized("INFO", ("Game level read: " + std::to_string(meshCount) + " meshes of " +
+			std::to_string(outModels.size()) + " models in " + std::to_string(std::chrono::duration<double,
+				std::milli>(std::chrono::steady_clock::now() - start).count()) + " ms").c_str());
+		log.LogCategorized("MESSAGE", "Game Level File Reading Complete.");
+		return true;
+	}
+	// internal helper for reading a .blvl (see LevelLayout.h), same result as the text version
+	bool ReadBinaryLevel(const char* levelPath,
+		std::set<MODEL_ENTRY>& outModels,
+		GW::SYSTEM::GLog log) {
+		log.LogCategorized("MESSAGE", "Begin Reading Binary Game Level.");
+		auto start = std::chrono::steady_clock::now();
+		LevelLayout::View view;
+		if (view.Open(levelPath) == false) {
+			log.LogCategorized(
+				"ERROR", (std::string("Binary game level not found or invalid: ") + levelPath).c_str());
+			return false;
 		}
+		std::vector<MODEL_ENTRY> entries(view.ModelCount());
+		std::vector<unsigned> instanceCounts(entries.size(), 0);
+		for (size_t i = 0; i < view.RecordCount(); ++i)
+			++instanceCounts[view.records[i].modelId];
+		for (size_t i = 0; i < entries.size(); ++i) {
+			entries[i].modelFile = std::string(view.ModelName(static_cast<uint32_t>(i))) + ".h2b";
+			entries[i].blenderNames.reserve(instanceCounts[i]);
+			entries[i].instances.reserve(instanceCounts[i]);
+		}
+		for (size_t i = 0; i < view.RecordCount(); ++i) {
+			const LevelLayout::RECORD& r = view.records[i];
+			GW::MATH::GMATRIXF transform;
+			LevelLayout::Expand(r.transform, transform.data);
+			if (settings.logLevelObjects)
+				log.LogCategorized("INFO", (std::string("Model Detected: ") + view.ObjectName(r.nameId)).c_str());
+			entries[r.modelId].blenderNames.emplace_back(view.ObjectName(r.nameId)); // *NEW*
+			entries[r.modelId].instances.push_back(transform);
+		}
+		for (auto& e : entries)
+			if (e.instances.empty() == false)
+				outModels.insert(std::move(e));
+		log.LogCategorized("INFO", ("Binary game level read: " + std::to_string(view.RecordCount()) +
+			" meshes of " + std::to_string(outModels.size()) + " models in " + std::to_string(std::chrono::duration<double,
+				std::milli>(std::chrono::steady_clock::now() - start).count()) + " ms").c_str());
 		log.LogCategorized("MESSAGE", "Game Level File Reading Complete.");
 		return true;
 	}
 	// internal helper for collecting all .h2b data into unified arrays
 	bool ReadAndCombineH2Bs(const char* h2bFolderPath,
 		const std::set<MODEL_ENTRY>& modelSet,
+		std::vector<const void*>& outArrays,
 		GW::SYSTEM::GLog log) {
 		log.LogCategorized("MESSAGE", "Begin Importing .H2B File Data.");
-		// parse each model adding to overall arrays
-		H2B::Parser p; // reads the .h2b format
+		auto start = std::chrono::steady_clock::now();
+		const LEVEL_SIZE size = SizeFromHeaders(h2bFolderPath, modelSet);
+		const size_t reserved = ReserveLevel(size);
+		const double sizing = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		outArrays = ImportArrays();
+		bool combined = (settings.parallelImport) ?
+			CombineParallel(h2bFolderPath, modelSet, log) :
+			CombineSerial(h2bFolderPath, modelSet, log);
+		log.LogCategorized("INFO", ("Level sized from .h2b headers: " + std::to_string(size.vertices) + " vertices " +
+			std::to_string(size.indices) + " indices " + std::to_string(size.meshes) + " meshes " +
+			std::to_string(size.instances) + " instances, " + std::to_string(reserved / 1024) + " KB reserved in " +
+			std::to_string(sizing) + " ms").c_str());
+		log.LogCategorized("MESSAGE", "Importing of .H2B File Data Complete.");
+		return combined;
+	}
+	// *SIZING*
+	// Final sizes of the level arrays, summed before any geometry is read so each array
+	// is allocated exactly once instead of growing model by model.
+	struct LEVEL_SIZE
+	{
+		size_t models = 0, instances = 0;
+		size_t vertices = 0, indices = 0, materials = 0, meshes = 0;
+		size_t packedVertices = 0, indexBytes = 0, meshlets = 0, lods = 0; // processed (cached) models only
+	};
+	// first pass: reads only the 20 byte header of every .h2b (I/O bound, so more threads than cores).
+	// Generated LODs land in levelIndices too, each level at most half of the one before.
+	LEVEL_SIZE SizeFromHeaders(const char* h2bFolderPath, const std::set<MODEL_ENTRY>& modelSet) const {
+		std::vector<const MODEL_ENTRY*> entries;
+		entries.reserve(modelSet.size());
+		for (auto& e : modelSet)
+			entries.push_back(&e);
+		std::vector<H2B::COUNTS> counts(entries.size(), H2B::COUNTS{ 0, 0, 0, 0 });
 		const std::string modelPath = h2bFolderPath;
+		ParallelFor(entries.size(), [&](size_t i) {
+			if (H2B::ReadCounts((modelPath + "/" + entries[i]->modelFile).c_str(), counts[i]) == false)
+				counts[i] = H2B::COUNTS{ 0, 0, 0, 0 }; // reported as missing while importing
+		}, BatchRead::IO_THREADS);
+		LEVEL_SIZE size;
+		for (size_t i = 0; i < entries.size(); ++i) {
+			size.models += 1;
+			size.instances += entries[i]->instances.size();
+			size.vertices += counts[i].vertexCount;
+			size.indices += counts[i].indexCount;
+			size.materials += counts[i].materialCount;
+			size.meshes += counts[i].meshCount;
+			for (unsigned l = 1; settings.generateLods && l < settings.lodCount; ++l)
+				size.indices += counts[i].indexCount >> l;
+		}
+		return size;
+	}
+	// the same from models that were already processed
+	static LEVEL_SIZE SizeFromCache(const std::set<MODEL_ENTRY>& modelSet,
+		const std::vector<std::shared_ptr<const ModelCache::MODEL_DATA>>& models) {
+		LEVEL_SIZE size;
+		size_t at = 0;
+		for (auto& entry : modelSet) {
+			if (const ModelCache::MODEL_DATA* data = models[at++].get()) {
+				size.models += 1;
+				size.instances += entry.instances.size();
+				size.vertices += data->vertices.size();
+				size.indices += data->indices.size();
+				size.materials += data->materials.size();
+				size.meshes += data->meshes.size();
+				size.packedVertices += data->packedVertices.size();
+				size.indexBytes += data->indexBuffer.size();
+				size.meshlets += data->meshlets.size();
+				size.lods += data->meshLods.size();
+			}
+		}
+		return size;
+	}
+	// grows every array the import appends to by "size" at once, returns the bytes reserved
+	size_t ReserveLevel(const LEVEL_SIZE& size) {
+		size_t bytes = 0;
+		auto reserve = [&](auto& array, size_t count) {
+			if (count != 0) {
+				array.reserve(array.size() + count);
+				bytes += count * sizeof(array[0]);
+			}
+		};
+		reserve(levelVertices, size.vertices);
+		reserve(levelPackedVertices, size.packedVertices);
+		reserve(levelIndices, size.indices);
+		reserve(levelIndexBuffer, size.indexBytes);
+		reserve(levelMaterials, size.materials + 1); // upper bound, plus the fallback white
+		reserve(levelMaterialIds, size.materials);
+		reserve(levelMeshMaterials, size.meshes);
+		reserve(levelBatches, size.materials);
+		reserve(levelMeshes, size.meshes);
+		reserve(levelMeshlets, size.meshlets);
+		reserve(levelMeshletRanges, size.meshes);
+		reserve(levelMeshLods, size.lods);
+		reserve(levelMeshLodRanges, size.meshes);
+		reserve(levelMeshBounds, size.meshes);
+		reserve(levelModelBounds, size.models);
+		reserve(levelModels, size.models);
+		reserve(levelColliders, size.models);
+		reserve(levelInstances, size.models);
+		reserve(levelTransforms, size.instances);
+		reserve(blenderObjects, size.instances);
+		if (settings.hugePages) {
+			AdviseHugePages(levelVertices);
+			AdviseHugePages(levelPackedVertices);
+			AdviseHugePages(levelIndices);
+			AdviseHugePages(levelIndexBuffer);
+		}
+		return bytes;
+	}
+	// where the arrays the import appends to live, to catch any that had to grow anyway
+	std::vector<const void*> ImportArrays() const {
+		return { levelVertices.data(), levelPackedVertices.data(), levelIndices.data(), levelIndexBuffer.data(),
+			levelMaterials.data(), levelMaterialIds.data(), levelMeshMaterials.data(), levelBatches.data(),
+			levelMeshes.data(), levelMeshlets.data(), levelMeshLods.data(), levelModels.data(),
+			levelInstances.data(), levelTransforms.data(), blenderObjects.data() };
+	}
+	size_t CountRegrown(const std::vector<const void*>& before) const {
+		const std::vector<const void*> after = ImportArrays();
+		size_t regrown = 0;
+		for (size_t i = 0; i < before.size(); ++i)
+			regrown += (before[i] != nullptr && before[i] != after[i]) ? 1 : 0;
+		return regrown;
+	}
+	// Asks Linux for transparent 2 MB pages under the untouched part of a reserved array,
+	// fewer TLB misses while the processing passes sweep over it. A hint, nothing else changes.
+	template<typename T>
+	static void AdviseHugePages(const std::vector<T>& array) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		const uintptr_t page = 2 * 1024 * 1024;
+		const uintptr_t first = (reinterpret_cast<uintptr_t>(array.data()) + page - 1) & ~(page - 1);
+		const uintptr_t last = reinterpret_cast<uintptr_t>(array.data() + array.capacity()) & ~(page - 1);
+		if (last > first)
+			madvise(reinterpret_cast<void*>(first), last - first, MADV_HUGEPAGE);
+#else
+		(void)array;
+#endif
+	}
+	template<typename T>
+	static void Release(std::vector<T>& array) {
+		std::vector<T>().swap(array); // clear() would keep the capacity
+	}
+	// maps and appends one model at a time in std::set order
+	bool CombineSerial(const char* h2bFolderPath,
+		const std::set<MODEL_ENTRY>& modelSet,
+		GW::SYSTEM::GLog log) {
+		// map each model adding to overall arrays
+		H2B::View p; // reads the .h2b format in place (no intermediate copies)
+		const std::string modelPath = h2bFolderPath;
+		size_t done = 0;
 		for (auto i = modelSet.begin(); i != modelSet.end(); ++i)
 		{
-			if (p.Parse((modelPath + "/" + i->modelFile).c_str()))
+			if (p.Open((modelPath + "/" + i->modelFile).c_str()))
 			{
 				log.LogCategorized("INFO", (std::string("H2B Imported: ") + i->modelFile).c_str());
-				// transfer all string data
-				for (int j = 0; j < p.materialCount; ++j) {
-					for (int k = 0; k < 10; ++k) {
-						if (*((&p.materials[j].name) + k) != nullptr)
-							*((&p.materials[j].name) + k) =
-							level_strings.insert(*((&p.materials[j].name) + k)).first->c_str();
+				TransferStrings(p);
+				RecordModel(*i, p);
+				RecordMaterials(p.materials, p.meshes);
+				// append all data straight from the mapped file
+				levelVertices.insert(levelVertices.end(), p.vertices, p.vertices + p.vertexCount);
+				levelIndices.insert(levelIndices.end(), p.indices, p.indices + p.indexCount);
+				levelBatches.insert(levelBatches.end(), p.batches, p.batches + p.materialCount);
+				levelMeshes.insert(levelMeshes.end(), p.meshes.begin(), p.meshes.end());
+			}
+			else
+				ReportMissingModel(modelPath, *i, log);
+			ReportProgress(0.1f + 0.8f * ++done / modelSet.size());
+		}
+		p.Close(); // unmap the last model, all strings now live in level_strings
+		return true;
+	}
+	// maps every model on worker threads, lays the level arrays out with a
+	// prefix sum over the model sizes, then fills them in parallel.
+	// Produces exactly the same arrays as CombineSerial.
+	bool CombineParallel(const char* h2bFolderPath,
+		const std::set<MODEL_ENTRY>& modelSet,
+		GW::SYSTEM::GLog log) {
+		const std::string modelPath = h2bFolderPath;
+		std::vector<const MODEL_ENTRY*> entries;
+		entries.reserve(modelSet.size());
+		for (auto& e : modelSet)
+			entries.push_back(&e);
+		std::vector<H2B::View> views(entries.size());
+		std::vector<char> opened(entries.size(), 0);
+		// 1. map (or read) + validate all files concurrently
+		std::atomic<unsigned> mapped(0);
+		std::vector<size_t> mapping; // files mapped one by one, all of them without batchedReads
+		std::vector<size_t> inflating; // compressed in the mounted pack
+		std::vector<std::string> inflatePaths;
+		std::vector<size_t> reading; // loose files fetched in one batch
+		std::vector<BatchRead::REQUEST> reads;
+		for (size_t i = 0; i < entries.size(); ++i) {
+			std::string path = modelPath + "/" + entries[i]->modelFile;
+			if (VirtualFile::PackedCompressed(path.c_str())) {
+				inflating.push_back(i);
+				inflatePaths.push_back(std::move(path));
+			}
+			else if (settings.batchedReads == false || VirtualFile::InPack(path.c_str()))
+				mapping.push_back(i);
+			else {
+				reading.push_back(i);
+				reads.emplace_back();
+				reads.back().path = std::move(path);
+			}
+		}
+		if (inflating.empty() == false) {
+			// every packed model in one Decompress call, its threads split all their blocks
+			std::vector<std::vector<unsigned char>> inflated;
+			std::vector<char> ok = VirtualFile::InflateAll(inflatePaths, inflated);
+			ParallelFor(inflating.size(), [&](size_t n) {
+				const size_t i = inflating[n];
+				opened[i] = ok[n] && views[i].Adopt(std::move(inflated[n]));
+				ReportProgress(0.1f + 0.6f * ++mapped / entries.size());
+			});
+		}
+		ParallelFor(mapping.size(), [&](size_t m) {
+			const size_t i = mapping[m];
+			opened[i] = views[i].Open((modelPath + "/" + entries[i]->modelFile).c_str());
+			ReportProgress(0.1f + 0.6f * ++mapped / entries.size());
+		});
+		if (reads.empty() == false) {
+			// each file is validated as soon as its read lands while the rest are still in flight
+			BatchRead::STATS stats = BatchRead::ReadAll(reads, [&](size_t r) {
+				const size_t i = reading[r];
+				opened[i] = reads[r].ok && views[i].Adopt(std::move(reads[r].bytes));
+				ReportProgress(0.1f + 0.6f * ++mapped / entries.size());
+			});
+			log.LogCategorized("INFO", ("Batched .h2b reads: " + std::to_string(stats.files) + " files, " +
+				std::to_string(stats.bytes / 1024) + " KB in " + std::to_string(stats.seconds * 1000.0) + " ms through " +
+				(stats.uring ? "io_uring (" : "the thread pool (") + std::to_string(stats.MBps()) + " MB/s)").c_str());
+		}
+		// 2. serial bookkeeping in set order, starts become a running (prefix) sum
+		std::vector<LEVEL_MODEL> placed(entries.size());
+		for (size_t i = 0; i < entries.size(); ++i) {
+			if (opened[i]) {
+				log.LogCategorized("INFO", (std::string("H2B Imported: ") + entries[i]->modelFile).c_str());
+				TransferStrings(views[i]);
+				placed[i] = RecordModel(*entries[i], views[i]);
+				RecordMaterials(views[i].materials, views[i].meshes);
+			}
+			else
+				ReportMissingModel(modelPath, *entries[i], log);
+		}
+		ReportProgress(0.75f);
+		// 3. size every array once then copy each model into its own slice
+		levelVertices.resize(levelVertices.size() + CountTotal(placed, opened, &LEVEL_MODEL::vertexCount));
+		levelIndices.resize(levelIndices.size() + CountTotal(placed, opened, &LEVEL_MODEL::indexCount));
+		levelBatches.resize(levelBatches.size() + CountTotal(placed, opened, &LEVEL_MODEL::materialCount));
+		levelMeshes.resize(levelMeshes.size() + CountTotal(placed, opened, &LEVEL_MODEL::meshCount));
+		ParallelFor(entries.size(), [&](size_t i) {
+			if (opened[i] == false)
+				return;
+			const H2B::View& p = views[i];
+			const LEVEL_MODEL& m = placed[i];
+			std::copy(p.vertices, p.vertices + p.vertexCount, levelVertices.begin() + m.vertexStart);
+			std::copy(p.indices, p.indices + p.indexCount, levelIndices.begin() + m.indexStart);
+			std::copy(p.batches, p.batches + p.materialCount, levelBatches.begin() + m.batchStart);
+			std::copy(p.meshes.begin(), p.meshes.end(), levelMeshes.begin() + m.meshStart);
+		});
+		views.clear(); // unmap everything, all strings now live in level_strings
+		return true;
+	}
+	// moves a model's string pointers from the file over to level_strings
+	void TransferStrings(H2B::View& p) {
+		for (unsigned j = 0; j < p.materialCount; ++j) {
+			for (int k = 0; k < 10; ++k) {
+				if (*((&p.materials[j].name) + k) != nullptr)
+					*((&p.materials[j].name) + k) =
+					level_strings.InternString(*((&p.materials[j].name) + k));
+			}
+		}
+		for (unsigned j = 0; j < p.meshCount; ++j) {
+			if (p.meshes[j].name != nullptr)
+				p.meshes[j].name =
+				level_strings.InternString(p.meshes[j].name);
+		}
+	}
+	// adds the model, its instances and blender objects to the level.
+	// Geometry starts are taken from the current end of each array, in
+	// CombineParallel the arrays are only sized afterwards so they act as a prefix sum.
+	LEVEL_MODEL RecordModel(const MODEL_ENTRY& entry, const H2B::View& p) {
+		return RecordModel(entry, p.vertexCount, p.indexCount, p.materialCount, p.meshCount);
+	}
+	LEVEL_MODEL RecordModel(const MODEL_ENTRY& entry, unsigned vertexCount,
+		unsigned indexCount, unsigned materialCount, unsigned meshCount) {
+		// record source file name & sizes
+		LEVEL_MODEL model;
+		model.filename = level_strings.InternString(entry.modelFile);
+		model.vertexCount = vertexCount;
+		model.indexCount = indexCount;
+		model.materialCount = materialCount;
+		model.meshCount = meshCount;
+		model.indexFormat = 4; // until NarrowLevelIndices runs
+		model.indexByteOffset = 0;
+		// record offsets
+		if (levelModels.empty()) {
+			model.vertexStart = levelVertices.size();
+			model.indexStart = levelIndices.size();
+			model.materialStart = levelMaterialIds.size();
+			model.batchStart = levelBatches.size();
+			model.meshStart = levelMeshes.size();
+		}
+		else {
+			const LEVEL_MODEL& last = levelModels.back();
+			model.vertexStart = last.vertexStart + last.vertexCount;
+			model.indexStart = last.indexStart + last.indexCount;
+			model.materialStart = last.materialStart + last.materialCount;
+			model.batchStart = last.batchStart + last.materialCount;
+			model.meshStart = last.meshStart + last.meshCount;
+		}
+		// *NEW* add overall collision volume(OBB) for this model, ComputeInstanceBounds fills it in
+		model.colliderIndex = levelColliders.size();
+		levelColliders.push_back({});
+		// add level model
+		levelModels.push_back(model);
+		RecordInstances(entry, levelModels.size() - 1);
+		return model;
+	}
+	// adds the instances and blender objects of one model entry
+	void RecordInstances(const MODEL_ENTRY& entry, unsigned modelIndex) {
+		MODEL_INSTANCES instances;
+		instances.flags = 0; // shadows? transparency? much we could do with this.
+		instances.modelIndex = modelIndex;
+		instances.transformStart = levelTransforms.size();
+		instances.transformCount = entry.instances.size();
+		levelTransforms.insert(levelTransforms.end(), entry.instances.begin(), entry.instances.end());
+		// add instance set
+		levelInstances.push_back(instances);
+		// *NEW* Add an entry for each unique blender object
+		int offset = 0;
+		for (auto& n : entry.blenderNames) {
+			BLENDER_OBJECT obj{
+				level_strings.InternString(n),
+				instances.modelIndex, instances.transformStart + offset++
+			};
+			blenderObjects.push_back(obj);
+		}
+	}
+	// *MATERIALS*
+	// Identical materials of different models (and within one) end up as one entry of
+	// levelMaterials. Two materials are the same when their ATTRIBUTES match bit for bit
+	// and they name the same textures, the material name itself doesn't matter.
+	static unsigned long long MaterialHash(const H2B::MATERIAL& mat) {
+		unsigned long long hash = HashBytes(&mat.attrib, sizeof(H2B::ATTRIBUTES));
+		const unsigned char none = 0xFF; // can't appear inside a NUL terminated name
+		for (int k = 1; k < 10; ++k) { // map_Kd ... bump, NUL included so names can't run together
+			const char* str = *((&mat.name) + k);
+			hash = (str != nullptr) ? HashBytes(str, std::strlen(str) + 1, hash) : HashBytes(&none, 1, hash);
+		}
+		return hash;
+	}
+	static bool SameMaterial(const H2B::MATERIAL& a, const H2B::MATERIAL& b) {
+		if (std::memcmp(&a.attrib, &b.attrib, sizeof(H2B::ATTRIBUTES)) != 0)
+			return false;
+		for (int k = 1; k < 10; ++k) {
+			const char* x = *((&a.name) + k);
+			const char* y = *((&b.name) + k);
+			if (x != y && (x == nullptr || y == nullptr || std::strcmp(x, y) != 0))
+				return false;
+		}
+		return true;
+	}
+	// levelMaterials index of "mat" (strings already in level_strings), added if it is new
+	unsigned InternMaterial(const H2B::MATERIAL& mat) {
+		if (materialLookup.empty()) // cooked levels come without the lookup
+			for (unsigned i = 0; i < levelMaterials.size(); ++i)
+				materialLookup.emplace(MaterialHash(levelMaterials[i]), i);
+		const unsigned long long hash = MaterialHash(mat);
+		auto range = materialLookup.equal_range(hash);
+		for (auto i = range.first; i != range.second; ++i)
+			if (SameMaterial(levelMaterials[i->second], mat))
+				return i->second;
+		const unsigned index = static_cast<unsigned>(levelMaterials.size());
+		levelMaterials.push_back(mat);
+		materialLookup.emplace(hash, index);
+		return index;
+	}
+	// levelMaterials index of every material slot of one model
+	std::vector<unsigned> InternMaterials(const std::vector<H2B::MATERIAL>& materials) {
+		std::vector<unsigned> ids;
+		ids.reserve(materials.size());
+		for (const H2B::MATERIAL& mat : materials)
+			ids.push_back(InternMaterial(mat));
+		return ids;
+	}
+	// levelMaterials index of every mesh of one model, "ids" from InternMaterials
+	std::vector<unsigned> MeshMaterials(const std::vector<H2B::MESH>& meshes, const std::vector<unsigned>& ids) {
+		std::vector<unsigned> out;
+		out.reserve(meshes.size());
+		for (const H2B::MESH& mesh : meshes) {
+			if (mesh.materialIndex < ids.size())
+				out.push_back(ids[mesh.materialIndex]);
+			else if (ids.empty() == false)
+				out.push_back(ids[0]); // broken index, any material of the model beats none
+			else { // exported without materials, plain white
+				H2B::MATERIAL fallback = {};
+				fallback.attrib.Kd = { 1.0f, 1.0f, 1.0f };
+				fallback.attrib.d = 1.0f;
+				out.push_back(InternMaterial(fallback));
+			}
+		}
+		return out;
+	}
+	// appends the material slots & mesh materials of the model RecordModel just added
+	void RecordMaterials(const std::vector<H2B::MATERIAL>& materials, const std::vector<H2B::MESH>& meshes) {
+		std::vector<unsigned> ids = InternMaterials(materials);
+		std::vector<unsigned> meshIds = MeshMaterials(meshes, ids);
+		levelMaterialIds.insert(levelMaterialIds.end(), ids.begin(), ids.end());
+		levelMeshMaterials.insert(levelMeshMaterials.end(), meshIds.begin(), meshIds.end());
+	}
+	void ReportMaterials(GW::SYSTEM::GLog log) const {
+		log.LogCategorized("INFO", ("Materials: " + std::to_string(levelMaterialIds.size()) + " model slots share " +
+			std::to_string(levelMaterials.size()) + " unique materials (" +
+			std::to_string(levelMaterials.size() * sizeof(H2B::MATERIAL) / 1024) + " KB)").c_str());
+	}
+	// Takes every model it can from settings.modelCache, imports & processes only the
+	// rest, hands those to the cache, then lays the level out in the usual set order.
+	bool CombineCachedModels(const char* h2bFolderPath,
+		const std::set<MODEL_ENTRY>& modelSet,
+		GW::SYSTEM::GLog log) {
+		ModelCache& cache = *settings.modelCache;
+		const unsigned settingsHash = CookedSettingsHash();
+		std::vector<std::shared_ptr<const ModelCache::MODEL_DATA>> models;
+		std::vector<ModelCache::FILE_KEY> keys;
+		std::unordered_map<std::string, size_t> position; // modelFile -> set order
+		std::set<MODEL_ENTRY> missing;
+		for (auto& entry : modelSet) {
+			const std::string path = std::string(h2bFolderPath) + "/" + entry.modelFile;
+			position[entry.modelFile] = models.size();
+			keys.push_back(ModelCache::KeyOf(path, settingsHash));
+			models.push_back(cache.Find(path, keys.back()));
+			if (models.back() == nullptr)
+				missing.insert(entry);
+		}
+		log.LogCategorized("INFO", ("Model cache: " + std::to_string(modelSet.size() - missing.size()) +
+			" of " + std::to_string(modelSet.size()) + " models reused").c_str());
+		if (missing.empty() == false) {
+			std::vector<const void*> reserved;
+			if (ReadAndCombineH2Bs(h2bFolderPath, missing, reserved, log) == false)
+				return false;
+			ProcessLevelGeometry(log);
+			// the level now holds just the new models, copy each out for the cache
+			for (size_t i = 0; i < levelModels.size(); ++i) {
+				size_t at = position[levelModels[i].filename];
+				models[at] = ExtractModel(i);
+				cache.Insert(std::string(h2bFolderPath) + "/" + levelModels[i].filename, keys[at], models[at]);
+			}
+			UnloadLevel();
+		}
+		const LEVEL_SIZE size = SizeFromCache(modelSet, models);
+		ReserveLevel(size);
+		const std::vector<const void*> arrays = ImportArrays();
+		size_t at = 0;
+		for (auto& entry : modelSet) {
+			if (models[at] != nullptr) // missing files were reported while importing
+				AppendModel(entry, *models[at]);
+			++at;
+		}
+		if (size_t regrown = CountRegrown(arrays))
+			log.LogCategorized("WARNING", ("Model cache: " + std::to_string(regrown) + " level arrays regrew while appending").c_str());
+		ModelCache::STATS stats = cache.Stats();
+		log.LogCategorized("INFO", ("Model cache: " + std::to_string(stats.residentModels) + " models " +
+			std::to_string(stats.residentBytes / 1024) + " KB resident, " + std::to_string(stats.hits) +
+			" hits " + std::to_string(stats.misses) + " misses " + std::to_string(stats.evictions) +
+			" evictions so far").c_str());
+		return true;
+	}
+	// copies one processed model out of the level arrays
+	std::shared_ptr<const ModelCache::MODEL_DATA> ExtractModel(size_t modelIndex) const {
+		const LEVEL_MODEL& m = levelModels[modelIndex];
+		auto data = std::make_shared<ModelCache::MODEL_DATA>();
+		auto slice = [](auto& out, const auto& in, size_t start, size_t count) {
+			if (in.empty() == false)
+				out.assign(in.begin() + start, in.begin() + start + count);
+		};
+		slice(data->vertices, levelVertices, m.vertexStart, m.vertexCount);
+		slice(data->packedVertices, levelPackedVertices, m.vertexStart, m.vertexCount);
+		slice(data->indices, levelIndices, m.indexStart, m.indexCount);
+		slice(data->indexBuffer, levelIndexBuffer, m.indexByteOffset, (m.indexCount * m.indexFormat + 3) & ~size_t(3));
+		for (unsigned k = 0; k < m.materialCount; ++k)
+			data->materials.push_back(levelMaterials[levelMaterialIds[m.materialStart + k]]);
+		slice(data->batches, levelBatches, m.batchStart, m.materialCount);
+		slice(data->meshes, levelMeshes, m.meshStart, m.meshCount);
+		for (auto& mat : data->materials)
+			for (int k = 0; k < 10; ++k)
+				*((&mat.name) + k) = data->AddString(*((&mat.name) + k));
+		for (auto& mesh : data->meshes)
+			mesh.name = data->AddString(mesh.name);
+		for (unsigned j = 0; j < m.meshCount; ++j) {
+			if (levelMeshletRanges.empty() == false) {
+				const MESHLET_RANGE& r = levelMeshletRanges[m.meshStart + j];
+				data->meshletCounts.push_back(r.meshletCount);
+				data->meshlets.insert(data->meshlets.end(), levelMeshlets.begin() + r.meshletStart,
+					levelMeshlets.begin() + r.meshletStart + r.meshletCount);
+			}
+			if (levelMeshLodRanges.empty() == false) {
+				const LOD_RANGE& r = levelMeshLodRanges[m.meshStart + j];
+				data->lodCounts.push_back(r.lodCount);
+				data->meshLods.insert(data->meshLods.end(), levelMeshLods.begin() + r.lodStart,
+					levelMeshLods.begin() + r.lodStart + r.lodCount);
+			}
+		}
+		slice(data->meshBounds, levelMeshBounds, m.meshStart, m.meshCount);
+		data->modelBounds = levelModelBounds[modelIndex];
+		data->vertexBounds = m.vertexBounds;
+		data->indexFormat = m.indexFormat;
+		return data;
+	}
+	// appends a cached model, its instances and blender objects to the level
+	void AppendModel(const MODEL_ENTRY& entry, const ModelCache::MODEL_DATA& data) {
+		RecordModel(entry, static_cast<unsigned>(data.vertices.size()), static_cast<unsigned>(data.indices.size()),
+			static_cast<unsigned>(data.materials.size()), static_cast<unsigned>(data.meshes.size()));
+		LEVEL_MODEL& m = levelModels.back();
+		m.vertexBounds = data.vertexBounds;
+		m.indexFormat = data.indexFormat;
+		m.indexByteOffset = static_cast<unsigned>(levelIndexBuffer.size());
+		levelVertices.insert(levelVertices.end(), data.vertices.begin(), data.vertices.end());
+		levelPackedVertices.insert(levelPackedVertices.end(), data.packedVertices.begin(), data.packedVertices.end());
+		levelIndices.insert(levelIndices.end(), data.indices.begin(), data.indices.end());
+		levelIndexBuffer.insert(levelIndexBuffer.end(), data.indexBuffer.begin(), data.indexBuffer.end());
+		levelBatches.insert(levelBatches.end(), data.batches.begin(), data.batches.end());
+		levelMeshBounds.insert(levelMeshBounds.end(), data.meshBounds.begin(), data.meshBounds.end());
+		levelModelBounds.push_back(data.modelBounds);
+		std::vector<H2B::MESH> meshes = InternMeshes(data);
+		RecordMaterials(InternStrings(data), meshes);
+		levelMeshes.insert(levelMeshes.end(), meshes.begin(), meshes.end());
+		size_t first = 0; // cached meshlets & LODs are stored back to back per mesh
+		for (unsigned count : data.meshletCounts) {
+			levelMeshletRanges.push_back({ count, static_cast<unsigned>(levelMeshlets.size()) });
+			levelMeshlets.insert(levelMeshlets.end(), data.meshlets.begin() + first, data.meshlets.begin() + first + count);
+			first += count;
+		}
+		first = 0;
+		for (unsigned count : data.lodCounts) {
+			levelMeshLodRanges.push_back({ count, static_cast<unsigned>(levelMeshLods.size()) });
+			levelMeshLods.insert(levelMeshLods.end(), data.meshLods.begin() + first, data.meshLods.begin() + first + count);
+			first += count;
+		}
+	}
+	// a cached model's materials & meshes with their names moved into level_strings
+	std::vector<H2B::MATERIAL> InternStrings(const ModelCache::MODEL_DATA& data) {
+		std::vector<H2B::MATERIAL> materials = data.materials;
+		for (H2B::MATERIAL& mat : materials)
+			for (int k = 0; k < 10; ++k) {
+				const char* str = data.GetString(*((&mat.name) + k));
+				*((&mat.name) + k) = (str != nullptr) ? level_strings.InternString(str) : nullptr;
+			}
+		return materials;
+	}
+	std::vector<H2B::MESH> InternMeshes(const ModelCache::MODEL_DATA& data) {
+		std::vector<H2B::MESH> meshes = data.meshes;
+		for (H2B::MESH& mesh : meshes) {
+			const char* str = data.GetString(mesh.name);
+			mesh.name = (str != nullptr) ? level_strings.InternString(str) : nullptr;
+		}
+		return meshes;
+	}
+	// levelModels.size() when the level doesn't use "modelFile"
+	size_t FindModel(const char* modelFile) const {
+		for (size_t i = 0; i < levelModels.size(); ++i)
+			if (std::strcmp(levelModels[i].filename, modelFile) == 0)
+				return i;
+		return levelModels.size();
+	}
+	// one model imported & processed on its own, through settings.modelCache when set
+	std::shared_ptr<const ModelCache::MODEL_DATA> ImportModel(const char* h2bFolderPath,
+		const std::string& modelFile, GW::SYSTEM::GLog log) {
+		const std::string path = std::string(h2bFolderPath) + "/" + modelFile;
+		ModelCache::FILE_KEY key = ModelCache::KeyOf(path, CookedSettingsHash());
+		if (settings.modelCache != nullptr)
+			if (auto cached = settings.modelCache->Find(path, key))
+				return cached;
+		Level_Data scratch; // same settings, minus anything that outlives this call
+		scratch.settings = settings;
+		scratch.settings.modelCache = nullptr;
+		scratch.settings.useCookedLevels = false;
+		scratch.settings.parallelImport = false;
+		MODEL_ENTRY entry;
+		entry.modelFile = modelFile;
+		std::set<MODEL_ENTRY> one;
+		one.insert(std::move(entry));
+		std::vector<const void*> reserved;
+		if (scratch.ReadAndCombineH2Bs(h2bFolderPath, one, reserved, log) == false || scratch.levelModels.empty())
+			return nullptr;
+		scratch.ProcessLevelGeometry(log);
+		auto data = scratch.ExtractModel(0);
+		if (settings.modelCache != nullptr)
+			settings.modelCache->Insert(path, key, data);
+		return data;
+	}
+	// overwrites [start, start + count) when "data" fits in it, appends it otherwise
+	template <typename T, typename Source>
+	static unsigned PlaceRange(std::vector<T>& level, size_t start, size_t count, const Source& data) {
+		if (data.size() <= count) {
+			std::copy(data.begin(), data.end(), level.begin() + start);
+			return static_cast<unsigned>(start);
+		}
+		start = level.size();
+		level.insert(level.end(), data.begin(), data.end());
+		return static_cast<unsigned>(start);
+	}
+	// Writes a processed model over the ranges of levelModels[modelIndex]. Each range is
+	// reused when the new data fits and appended otherwise, the old one then sits unused
+	// until the next full load. Meshlets & LODs of a model are always back to back.
+	void ReplaceModel(size_t modelIndex, const ModelCache::MODEL_DATA& data, LEVEL_PATCH& patch) {
+		LEVEL_MODEL& m = levelModels[modelIndex];
+		const unsigned vertexCount = static_cast<unsigned>(data.vertices.size());
+		const unsigned indexCount = static_cast<unsigned>(data.indices.size());
+		const unsigned materialCount = static_cast<unsigned>(data.materials.size());
+		const unsigned meshCount = static_cast<unsigned>(data.meshes.size());
+		// geometry, the part the renderer has to upload again
+		const unsigned vertexStart = PlaceRange(levelVertices, m.vertexStart, m.vertexCount, data.vertices);
+		if (levelPackedVertices.empty() == false) // kept the same size as levelVertices
+			PlaceRange(levelPackedVertices, m.vertexStart, m.vertexCount, data.packedVertices);
+		patch.AddVertices(vertexStart, vertexCount);
+		if (levelIndexBuffer.empty() == false) {
+			m.indexByteOffset = PlaceRange(levelIndexBuffer, m.indexByteOffset,
+				(size_t(m.indexCount) * m.indexFormat + 3) & ~size_t(3), data.indexBuffer);
+			patch.AddIndexBytes(m.indexByteOffset, data.indexBuffer.size());
+		}
+		m.indexStart = PlaceRange(levelIndices, m.indexStart, m.indexCount, data.indices);
+		if (levelIndexBuffer.empty())
+			patch.AddIndexBytes(size_t(m.indexStart) * sizeof(unsigned), size_t(indexCount) * sizeof(unsigned));
+		// draw ranges, materials & everything kept per mesh
+		const std::vector<unsigned> ids = InternMaterials(InternStrings(data));
+		const std::vector<H2B::MESH> meshes = InternMeshes(data);
+		m.materialStart = PlaceRange(levelMaterialIds, m.materialStart, m.materialCount, ids);
+		m.batchStart = PlaceRange(levelBatches, m.batchStart, m.materialCount, data.batches);
+		const unsigned meshStart = PlaceRange(levelMeshes, m.meshStart, m.meshCount, meshes);
+		PlaceRange(levelMeshMaterials, m.meshStart, m.meshCount, MeshMaterials(meshes, ids));
+		PlaceRange(levelMeshBounds, m.meshStart, m.meshCount, data.meshBounds);
+		// meshes drawing another model's geometry own none of the meshlets & LODs they point at
+		auto ownMesh = [&](unsigned j) {
+			return levelMeshGeometry.empty() || levelMeshGeometry[m.meshStart + j] == modelIndex;
+		};
+		if (levelMeshletRanges.empty() == false) {
+			unsigned oldStart = 0, oldCount = 0;
+			for (unsigned j = 0; j < m.meshCount; ++j) {
+				if (ownMesh(j) == false)
+					continue;
+				const MESHLET_RANGE& r = levelMeshletRanges[m.meshStart + j];
+				oldStart = (oldCount == 0) ? r.meshletStart : oldStart;
+				oldCount += r.meshletCount;
+			}
+			unsigned first = PlaceRange(levelMeshlets, oldStart, oldCount, data.meshlets);
+			std::vector<MESHLET_RANGE> ranges;
+			for (unsigned count : data.meshletCounts) {
+				ranges.push_back({ count, first });
+				first += count;
+			}
+			PlaceRange(levelMeshletRanges, m.meshStart, m.meshCount, ranges);
+		}
+		if (levelMeshLodRanges.empty() == false) {
+			unsigned oldStart = 0, oldCount = 0;
+			for (unsigned j = 0; j < m.meshCount; ++j) {
+				if (ownMesh(j) == false)
+					continue;
+				const LOD_RANGE& r = levelMeshLodRanges[m.meshStart + j];
+				oldStart = (oldCount == 0) ? r.lodStart : oldStart;
+				oldCount += r.lodCount;
+			}
+			unsigned first = PlaceRange(levelMeshLods, oldStart, oldCount, data.meshLods);
+			std::vector<LOD_RANGE> ranges;
+			for (unsigned count : data.lodCounts) {
+				ranges.push_back({ count, first });
+				first += count;
+			}
+			PlaceRange(levelMeshLodRanges, m.meshStart, m.meshCount, ranges);
+		}
+		if (levelMeshGeometry.empty() == false) // the new data is whole, nothing is shared anymore
+			PlaceRange(levelMeshGeometry, m.meshStart, m.meshCount,
+				std::vector<unsigned>(meshCount, static_cast<unsigned>(modelIndex)));
+		m.vertexStart = vertexStart;
+		m.meshStart = meshStart;
+		m.vertexCount = vertexCount;
+		m.indexCount = indexCount;
+		m.materialCount = materialCount;
+		m.meshCount = meshCount;
+		m.vertexBounds = data.vertexBounds;
+		m.indexFormat = data.indexFormat;
+		levelModelBounds[modelIndex] = data.modelBounds;
+	}
+	static size_t CountTotal(const std::vector<LEVEL_MODEL>& models,
+		const std::vector<char>& used, unsigned LEVEL_MODEL::* count) {
+		size_t total = 0;
+		for (size_t i = 0; i < models.size(); ++i)
+			if (used[i])
+				total += models[i].*count;
+		return total;
+	}
+	void ReportMissingModel(const std::string& modelPath, const MODEL_ENTRY& entry,
+		GW::SYSTEM::GLog log) {
+		// notify user that a model file is missing (or malformed) but continue loading
+		log.LogCategorized("ERROR",
+			(std::string("H2B Not Found: ") + modelPath + "/" + entry.modelFile).c_str());
+		log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
+	}
+	// *COOKED LEVELS* 
+	// A .lvlbin is every level array written back to back (16 byte aligned) after
+	// a header, with all string pointers replaced by offsets into a string table.
+	// It is only trusted while the size & modification time of every input file
+	// (level txt + each referenced .h2b) still hash to the value it was cooked with.
+	// The big geometry arrays may be stored as BlockCompression streams (packed != 0),
+	// those are inflated in parallel straight into the level arrays.
+	static constexpr unsigned COOKED_VERSION = 11;
+	struct COOKED_SECTION { unsigned long long offset, count, packed; }; // packed: stream bytes, 0 = raw
+	struct COOKED_HEADER
+	{
+		char magic[4]; // "LVLB"
+		unsigned version; // COOKED_VERSION
+		unsigned pointerSize; // strings are patched in place, so 32/64 bit blobs differ
+		unsigned settingsHash; // import settings that change the output
+		unsigned long long inputHash; // paths, sizes and mtimes of every input file
+		COOKED_SECTION strings, inputs, vertices, indices, materials, batches, meshes,
+			models, transforms, colliders, instances, blenderObjects, packedVertices, indexBuffer,
+			meshlets, meshletRanges, meshLods, meshLodRanges, meshBounds, modelBounds, instanceBounds,
+			materialIds, meshMaterials, meshGeometry;
+	};
+	// GameLevel.txt -> GameLevel.lvlbin, other layouts keep their extension so they don't share one
+	static std::string CookedLevelPath(const char* gameLevelPath) {
+		std::string path = gameLevelPath;
+		if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".txt") == 0)
+			path.erase(path.size() - 4);
+		return path + ".lvlbin";
+	}
+	// every file the level is built from, missing .h2bs included so adding one invalidates
+	static std::vector<std::string> CookedLevelInputs(const char* gameLevelPath,
+		const char* h2bFolderPath, const std::set<MODEL_ENTRY>& modelSet) {
+		std::vector<std::string> inputs = { gameLevelPath };
+		for (auto& m : modelSet)
+			inputs.push_back(std::string(h2bFolderPath) + "/" + m.modelFile);
+		return inputs;
+	}
+	static unsigned long long HashBytes(const void* data, size_t size,
+		unsigned long long hash = 14695981039346656037ull) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i]; // FNV-1a
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+	static unsigned long long HashCookedInputs(const std::vector<const char*>& inputs) {
+		unsigned long long hash = HashBytes(&COOKED_VERSION, sizeof(COOKED_VERSION));
+		for (const char* path : inputs) {
+			unsigned long long size = ~0ull;
+			long long modified = 0;
+			VirtualFile::Stat(path, size, modified);
+			hash = HashBytes(path, std::strlen(path) + 1, hash);
+			hash = HashBytes(&size, sizeof(size), hash);
+			hash = HashBytes(&modified, sizeof(modified), hash);
+		}
+		return hash;
+	}
+	unsigned CookedSettingsHash() const {
+		unsigned bits = 0; // one bit per import setting that changes the cooked arrays
+		bits |= settings.packVertices ? 1u : 0u;
+		bits |= settings.narrowIndices ? 2u : 0u;
+		bits |= settings.optimizeVertexCache ? 4u : 0u;
+		bits |= settings.optimizeOverdraw ? 8u : 0u;
+		bits |= settings.weldVertices ? 16u : 0u;
+		bits |= settings.buildMeshlets ? 32u : 0u;
+		bits |= settings.generateLods ? 64u : 0u;
+		bits |= settings.shareGeometry ? 128u : 0u;
+		// tuning values of the enabled passes end up in the upper half
+		unsigned long long tuning = HashBytes(&bits, sizeof(bits));
+		if (settings.optimizeOverdraw)
+			tuning = HashBytes(&settings.overdrawThreshold, sizeof(float), tuning);
+		if (settings.weldVertices)
+			tuning = HashBytes(&settings.weldEpsilon, sizeof(float), tuning);
+		if (settings.buildMeshlets) {
+			tuning = HashBytes(&settings.meshletMaxVertices, sizeof(unsigned), tuning);
+			tuning = HashBytes(&settings.meshletMaxTriangles, sizeof(unsigned), tuning);
+		}
+		if (settings.generateLods)
+			tuning = HashBytes(&settings.lodCount, sizeof(unsigned), tuning);
+		return (bits & 0xFFFFu) | (static_cast<unsigned>(tuning) << 16);
+	}
+	bool WriteCookedLevel(const char* cookedPath,
+		const std::vector<std::string>& inputs,
+		GW::SYSTEM::GLog log) {
+		// string table, interned pointers are unique so they key their own offsets
+		std::vector<char> strings;
+		std::unordered_map<const char*, unsigned long long> stringOffsets;
+		auto addString = [&](const char* str) -> unsigned long long {
+			if (str == nullptr)
+				return 0;
+			auto found = stringOffsets.find(str);
+			if (found != stringOffsets.end())
+				return found->second;
+			unsigned long long offset = strings.size() + 1; // 0 is reserved for nullptr
+			strings.insert(strings.end(), str, str + std::strlen(str) + 1);
+			stringOffsets[str] = offset;
+			return offset;
+		};
+		auto toOffset = [&](const char*& str) {
+			str = reinterpret_cast<const char*>(static_cast<uintptr_t>(addString(str)));
+		};
+		std::vector<unsigned long long> inputOffsets;
+		std::vector<const char*> inputPaths;
+		for (auto& in : inputs) {
+			inputOffsets.push_back(addString(in.c_str()));
+			inputPaths.push_back(in.c_str());
+		}
+		std::vector<H2B::MATERIAL> materials = levelMaterials;
+		for (auto& m : materials)
+			for (int k = 0; k < 10; ++k)
+				toOffset(*((&m.name) + k));
+		std::vector<H2B::MESH> meshes = levelMeshes;
+		for (auto& m : meshes)
+			toOffset(m.name);
+		std::vector<LEVEL_MODEL> models = levelModels;
+		for (auto& m : models)
+			toOffset(m.filename);
+		std::vector<BLENDER_OBJECT> objects = blenderObjects;
+		for (auto& o : objects)
+			toOffset(o.blendername);
+		// lay out the blob
+		COOKED_HEADER header = {};
+		std::memcpy(header.magic, "LVLB", 4);
+		header.version = COOKED_VERSION;
+		header.pointerSize = sizeof(void*);
+		header.settingsHash = CookedSettingsHash();
+		header.inputHash = HashCookedInputs(inputPaths);
+		std::vector<unsigned char> blob(sizeof(COOKED_HEADER));
+		unsigned long long rawBytes = 0, packedBytes = 0;
+		auto append = [&](COOKED_SECTION& section, const void* data, size_t count, size_t stride,
+			bool compress = false) {
+			blob.resize((blob.size() + 15) & ~size_t(15));
+			section.offset = blob.size();
+			section.count = count;
+			section.packed = 0;
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			if (compress && settings.compressCooked && count > 0) {
+				std::vector<unsigned char> packed =
+					BlockCompression::Compress(bytes, count * stride, settings.cookedBlockSize);
+				rawBytes += count * stride;
+				packedBytes += packed.size();
+				section.packed = packed.size();
+				blob.insert(blob.end(), packed.begin(), packed.end());
+			}
+			else
+				blob.insert(blob.end(), bytes, bytes + count * stride);
+		};
+		append(header.strings, strings.data(), strings.size(), 1);
+		append(header.inputs, inputOffsets.data(), inputOffsets.size(), sizeof(unsigned long long));
+		append(header.vertices, levelVertices.data(), levelVertices.size(), sizeof(H2B::VERTEX), true);
+		append(header.indices, levelIndices.data(), levelIndices.size(), sizeof(unsigned), true);
+		append(header.materials, materials.data(), materials.size(), sizeof(H2B::MATERIAL));
+		append(header.batches, levelBatches.data(), levelBatches.size(), sizeof(H2B::BATCH));
+		append(header.meshes, meshes.data(), meshes.size(), sizeof(H2B::MESH));
+		append(header.models, models.data(), models.size(), sizeof(LEVEL_MODEL));
+		append(header.transforms, levelTransforms.data(), levelTransforms.size(), sizeof(GW::MATH::GMATRIXF));
+		append(header.colliders, levelColliders.data(), levelColliders.size(), sizeof(GW::MATH::GOBBF));
+		append(header.instances, levelInstances.data(), levelInstances.size(), sizeof(MODEL_INSTANCES));
+		append(header.blenderObjects, objects.data(), objects.size(), sizeof(BLENDER_OBJECT));
+		append(header.packedVertices, levelPackedVertices.data(), levelPackedVertices.size(), sizeof(VertexPacking::PACKED_VERTEX), true);
+		append(header.indexBuffer, levelIndexBuffer.data(), levelIndexBuffer.size(), 1, true);
+		append(header.meshlets, levelMeshlets.data(), levelMeshlets.size(), sizeof(MeshOptimizer::MESHLET), true);
+		append(header.meshletRanges, levelMeshletRanges.data(), levelMeshletRanges.size(), sizeof(MESHLET_RANGE));
+		append(header.meshLods, levelMeshLods.data(), levelMeshLods.size(), sizeof(MeshOptimizer::MESH_LOD), true);
+		append(header.meshLodRanges, levelMeshLodRanges.data(), levelMeshLodRanges.size(), sizeof(LOD_RANGE));
+		append(header.meshBounds, levelMeshBounds.data(), levelMeshBounds.size(), sizeof(Bounds::VOLUME));
+		append(header.modelBounds, levelModelBounds.data(), levelModelBounds.size(), sizeof(Bounds::VOLUME));
+		append(header.instanceBounds, levelInstanceBounds.data(), levelInstanceBounds.size(), sizeof(Bounds::VOLUME));
+		append(header.materialIds, levelMaterialIds.data(), levelMaterialIds.size(), sizeof(unsigned));
+		append(header.meshMaterials, levelMeshMaterials.data(), levelMeshMaterials.size(), sizeof(unsigned));
+		append(header.meshGeometry, levelMeshGeometry.data(), levelMeshGeometry.size(), sizeof(unsigned));
+		std::memcpy(blob.data(), &header, sizeof(header));
+		// written next to the live file then renamed over it, a crash mid write leaves the old one intact
+		const std::string writing = std::string(cookedPath) + ".tmp";
+		std::ofstream file(writing, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		bool written = file.is_open() &&
+			file.write(reinterpret_cast<const char*>(blob.data()), blob.size()).good();
+		file.close();
+		std::error_code error;
+		if (written)
+			std::filesystem::rename(writing, cookedPath, error);
+		if (written == false || error) {
+			std::filesystem::remove(writing, error);
+			log.LogCategorized("WARNING", (std::string("Could not write cooked level: ") + cookedPath).c_str());
+			return false;
+		}
+		log.LogCategorized("MESSAGE", (std::string("Cooked level written: ") + cookedPath).c_str());
+		if (packedBytes > 0)
+			log.LogCategorized("INFO", ("Cooked geometry compressed " + std::to_string(rawBytes / 1024) + " KB -> " +
+				std::to_string(packedBytes / 1024) + " KB").c_str());
+		return true;
+	}
+	// Every start, count and index of the arrays read from a .lvlbin lies inside the array it
+	// refers to. The input hash only says the blob is current, not that its bytes are intact,
+	// and the renderer and hot reload index with these values unchecked.
+	bool CookedRangesFit() const {
+		auto fits = [](unsigned long long start, unsigned long long count, size_t size) {
+			return start <= size && count <= size - start;
+		};
+		const size_t meshes = levelMeshes.size();
+		bool valid = levelMeshMaterials.size() == meshes && levelMeshBounds.size() == meshes &&
+			levelModelBounds.size() == levelModels.size() &&
+			levelInstanceBounds.size() == levelTransforms.size() &&
+			(levelPackedVertices.empty() || levelPackedVertices.size() == levelVertices.size()) &&
+			(levelMeshletRanges.empty() || levelMeshletRanges.size() == meshes) &&
+			(levelMeshLodRanges.empty() || levelMeshLodRanges.size() == meshes);
+		for (size_t i = 0; valid && i < levelModels.size(); ++i) {
+			const LEVEL_MODEL& m = levelModels[i];
+			valid = fits(m.vertexStart, m.vertexCount, levelVertices.size()) &&
+				fits(m.indexStart, m.indexCount, levelIndices.size()) &&
+				fits(m.batchStart, m.materialCount, levelBatches.size()) &&
+				fits(m.materialStart, m.materialCount, levelMaterialIds.size()) &&
+				fits(m.meshStart, m.meshCount, meshes) &&
+				m.colliderIndex < levelColliders.size() && (m.indexFormat == 2 || m.indexFormat == 4) &&
+				(levelIndexBuffer.empty() || fits(m.indexByteOffset,
+					(static_cast<unsigned long long>(m.indexCount) * m.indexFormat + 3) & ~3ull, levelIndexBuffer.size()));
+			for (unsigned k = 0; valid && k < m.indexCount; ++k)
+				valid = levelIndices[m.indexStart + k] < m.vertexCount;
+			// draw ranges are relative to the model whose geometry the mesh draws from
+			for (unsigned j = 0; valid && j < m.meshCount; ++j) {
+				const size_t mesh = m.meshStart + j;
+				const LEVEL_MODEL& geometry = levelMeshGeometry.empty() ? m : levelModels[levelMeshGeometry[mesh]];
+				const H2B::BATCH& draw = levelMeshes[mesh].drawInfo;
+				valid = fits(draw.indexOffset, draw.indexCount, geometry.indexCount);
+				if (valid && levelMeshletRanges.empty() == false) {
+					const MESHLET_RANGE& r = levelMeshletRanges[mesh];
+					valid = fits(r.meshletStart, r.meshletCount, levelMeshlets.size());
+					for (unsigned k = 0; valid && k < r.meshletCount; ++k) {
+						const MeshOptimizer::MESHLET& meshlet = levelMeshlets[r.meshletStart + k];
+						valid = fits(meshlet.indexOffset, meshlet.triangleCount * 3ull, geometry.indexCount);
 					}
 				}
-				for (int j = 0; j < p.meshCount; ++j) {
-					if (p.meshes[j].name != nullptr)
-						p.meshes[j].name =
-						level_strings.insert(p.meshes[j].name).first->c_str();
-				}
-				// record source file name & sizes
-				LEVEL_MODEL model;
-				model.filename = level_strings.insert(i->modelFile).first->c_str();
-				model.vertexCount = p.vertexCount;
-				model.indexCount = p.indexCount;
-				model.materialCount = p.materialCount;
-				model.meshCount = p.meshCount;
-				// record offsets
-				model.vertexStart = levelVertices.size();
-				model.indexStart = levelIndices.size();
-				model.materialStart = levelMaterials.size();
-				model.batchStart = levelBatches.size();
-				model.meshStart = levelMeshes.size();
-				// append/move all data
-				levelVertices.insert(levelVertices.end(), p.vertices.begin(), p.vertices.end());
-				levelIndices.insert(levelIndices.end(), p.indices.begin(), p.indices.end());
-				levelMaterials.insert(levelMaterials.end(), p.materials.begin(), p.materials.end());
-				levelBatches.insert(levelBatches.end(), p.batches.begin(), p.batches.end());
-				levelMeshes.insert(levelMeshes.end(), p.meshes.begin(), p.meshes.end());
-				// *NEW* add overall collision volume(OBB) for this model and it's submeshes 
-				model.colliderIndex = levelColliders.size();
-				levelColliders.push_back(i->ComputeOBB());
-				// add level model
-				levelModels.push_back(model);
-				// add level model instances
-				MODEL_INSTANCES instances;
-				instances.flags = 0; // shadows? transparency? much we could do with this.
-				instances.modelIndex = levelModels.size() - 1;
-				instances.transformStart = levelTransforms.size();
-				instances.transformCount = i->instances.size();
-				levelTransforms.insert(levelTransforms.end(), i->instances.begin(), i->instances.end());
-				// add instance set
-				levelInstances.push_back(instances);
-				// *NEW* Add an entry for each unique blender object
-				int offset = 0;
-				for (auto& n : i->blenderNames) {
-					BLENDER_OBJECT obj{
-						level_strings.insert(n).first->c_str(),
-						instances.modelIndex, instances.transformStart + offset++
-					};
-					blenderObjects.push_back(obj);
+				if (valid && levelMeshLodRanges.empty() == false) {
+					const LOD_RANGE& r = levelMeshLodRanges[mesh];
+					valid = r.lodCount != 0 && fits(r.lodStart, r.lodCount, levelMeshLods.size()); // the first is the mesh
+					for (unsigned k = 0; valid && k < r.lodCount; ++k) {
+						const MeshOptimizer::MESH_LOD& lod = levelMeshLods[r.lodStart + k];
+						valid = fits(lod.indexOffset, lod.indexCount, geometry.indexCount);
+					}
 				}
 			}
-			else {
-				// notify user that a model file is missing but continue loading
-				log.LogCategorized("ERROR",
-					(std::string("H2B Not Found: ") + modelPath + "/" + i->modelFile).c_str());
-				log.LogCategorized("WARNING", "Loading will continue but model(s) are missing.");
+		}
+		for (size_t i = 0; valid && i < levelInstances.size(); ++i) {
+			const MODEL_INSTANCES& set = levelInstances[i];
+			valid = set.modelIndex < levelModels.size() && fits(set.transformStart, set.transformCount, levelTransforms.size());
+		}
+		for (size_t i = 0; valid && i < blenderObjects.size(); ++i)
+			valid = blenderObjects[i].modelIndex < levelModels.size() && blenderObjects[i].transformIndex < levelTransforms.size();
+		return valid;
+	}
+	bool ReadCookedLevel(const char* cookedPath, GW::SYSTEM::GLog log) {
+		if (cookedLevel.Open(cookedPath) == false)
+			return false; // never cooked, nothing to report
+		const unsigned char* base = cookedLevel.Data();
+		const size_t size = cookedLevel.Size();
+		COOKED_HEADER header;
+		if (size < sizeof(header)) {
+			cookedLevel.Close();
+			return false;
+		}
+		std::memcpy(&header, base, sizeof(header));
+		bool valid = std::memcmp(header.magic, "LVLB", 4) == 0 &&
+			header.version == COOKED_VERSION &&
+			header.pointerSize == sizeof(void*) &&
+			header.settingsHash == CookedSettingsHash();
+		auto inBounds = [&](const COOKED_SECTION& s, size_t stride) {
+			if (s.packed != 0) // the stream itself checks it inflates to count * stride
+				return s.offset <= size && s.packed <= size - s.offset && s.count <= ~size_t(0) / stride;
+			return s.offset <= size && s.count <= (size - s.offset) / stride;
+		};
+		valid = valid && inBounds(header.strings, 1) &&
+			inBounds(header.inputs, sizeof(unsigned long long)) &&
+			inBounds(header.vertices, sizeof(H2B::VERTEX)) &&
+			inBounds(header.indices, sizeof(unsigned)) &&
+			inBounds(header.materials, sizeof(H2B::MATERIAL)) &&
+			inBounds(header.batches, sizeof(H2B::BATCH)) &&
+			inBounds(header.meshes, sizeof(H2B::MESH)) &&
+			inBounds(header.models, sizeof(LEVEL_MODEL)) &&
+			inBounds(header.transforms, sizeof(GW::MATH::GMATRIXF)) &&
+			inBounds(header.colliders, sizeof(GW::MATH::GOBBF)) &&
+			inBounds(header.instances, sizeof(MODEL_INSTANCES)) &&
+			inBounds(header.blenderObjects, sizeof(BLENDER_OBJECT)) &&
+			inBounds(header.packedVertices, sizeof(VertexPacking::PACKED_VERTEX)) &&
+			inBounds(header.indexBuffer, 1) &&
+			inBounds(header.meshlets, sizeof(MeshOptimizer::MESHLET)) &&
+			inBounds(header.meshletRanges, sizeof(MESHLET_RANGE)) &&
+			inBounds(header.meshLods, sizeof(MeshOptimizer::MESH_LOD)) &&
+			inBounds(header.meshLodRanges, sizeof(LOD_RANGE)) &&
+			inBounds(header.meshBounds, sizeof(Bounds::VOLUME)) &&
+			inBounds(header.modelBounds, sizeof(Bounds::VOLUME)) &&
+			inBounds(header.instanceBounds, sizeof(Bounds::VOLUME)) &&
+			inBounds(header.materialIds, sizeof(unsigned)) &&
+			inBounds(header.meshMaterials, sizeof(unsigned)) &&
+			inBounds(header.meshGeometry, sizeof(unsigned)) &&
+			header.strings.packed == 0 && header.inputs.packed == 0 && // read before anything is inflated
+			header.strings.count > 0 && base[header.strings.offset + header.strings.count - 1] == '\0';
+		const char* strings = reinterpret_cast<const char*>(base + header.strings.offset);
+		// offsets are 1 based so 0 can stand for nullptr
+		auto toPointer = [&](const char*& str) -> bool {
+			uintptr_t offset = reinterpret_cast<uintptr_t>(str);
+			if (offset > header.strings.count)
+				return false;
+			str = (offset != 0) ? strings + offset - 1 : nullptr;
+			return true;
+		};
+		if (valid) { // out of date if any input changed since cooking
+			std::vector<const char*> inputs(header.inputs.count);
+			const unsigned long long* inputOffsets =
+				reinterpret_cast<const unsigned long long*>(base + header.inputs.offset);
+			for (size_t i = 0; valid && i < inputs.size(); ++i) {
+				inputs[i] = reinterpret_cast<const char*>(static_cast<uintptr_t>(inputOffsets[i]));
+				valid = toPointer(inputs[i]) && inputs[i] != nullptr;
 			}
+			valid = valid && HashCookedInputs(inputs) == header.inputHash;
 		}
-		log.LogCategorized("MESSAGE", "Importing of .H2B File Data Complete.");
+		if (valid == false) {
+			log.LogCategorized("MESSAGE", (std::string("Cooked level is stale, rebuilding: ") + cookedPath).c_str());
+			cookedLevel.Close();
+			return false;
+		}
+		// one sequential copy per raw array, compressed ones are sized & inflated together below
+		std::vector<BlockCompression::JOB> jobs;
+		auto load = [&](auto& out, const COOKED_SECTION& s) {
+			using T = typename std::decay_t<decltype(out)>::value_type;
+			if (s.packed != 0) {
+				uint64_t rawSize = 0; // the stream has to agree before anything is allocated
+				if (BlockCompression::RawSize(base + s.offset, static_cast<size_t>(s.packed), rawSize) == false ||
+					rawSize != s.count * sizeof(T)) {
+					valid = false;
+					return;
+				}
+				out.resize(s.count);
+				jobs.push_back({ base + s.offset, static_cast<size_t>(s.packed), out.data(), out.size() * sizeof(T) });
+				return;
+			}
+			const T* first = reinterpret_cast<const T*>(base + s.offset);
+			out.assign(first, first + s.count);
+		};
+		load(levelVertices, header.vertices);
+		load(levelIndices, header.indices);
+		load(levelMaterials, header.materials);
+		load(levelBatches, header.batches);
+		load(levelMeshes, header.meshes);
+		load(levelModels, header.models);
+		load(levelTransforms, header.transforms);
+		load(levelColliders, header.colliders);
+		load(levelInstances, header.instances);
+		load(blenderObjects, header.blenderObjects);
+		load(levelPackedVertices, header.packedVertices);
+		load(levelIndexBuffer, header.indexBuffer);
+		load(levelMeshlets, header.meshlets);
+		load(levelMeshletRanges, header.meshletRanges);
+		load(levelMeshLods, header.meshLods);
+		load(levelMeshLodRanges, header.meshLodRanges);
+		load(levelMeshBounds, header.meshBounds);
+		load(levelModelBounds, header.modelBounds);
+		load(levelInstanceBounds, header.instanceBounds);
+		load(levelMaterialIds, header.materialIds);
+		load(levelMeshMaterials, header.meshMaterials);
+		load(levelMeshGeometry, header.meshGeometry);
+		if (valid && jobs.empty() == false) {
+			BlockCompression::STATS stats;
+			valid = BlockCompression::Decompress(jobs, &stats);
+			if (valid)
+				log.LogCategorized("INFO", ("Cooked geometry inflated " + std::to_string(stats.rawBytes / 1024) +
+					" KB from " + std::to_string(stats.packedBytes / 1024) + " KB (" + std::to_string(stats.blocks) +
+					" blocks) in " + std::to_string(stats.seconds * 1000.0) + " ms, " +
+					std::to_string(static_cast<unsigned>(stats.MBps())) + " MB/s on " + std::to_string(stats.threads) +
+					" threads, " + std::to_string(static_cast<unsigned>(stats.MBpsPerCore())) + " MB/s per core").c_str());
+		}
+		// single fix up pass pointing every string into the mapping
+		for (auto& m : levelMaterials)
+			for (int k = 0; k < 10; ++k)
+				valid = toPointer(*((&m.name) + k)) && valid;
+		for (auto& m : levelMeshes)
+			valid = toPointer(m.name) && valid;
+		for (auto& m : levelModels)
+			valid = toPointer(m.filename) && valid;
+		for (auto& o : blenderObjects)
+			valid = toPointer(o.blendername) && valid;
+		valid = valid && levelMeshMaterials.size() == levelMeshes.size();
+		for (unsigned id : levelMaterialIds)
+			valid = valid && id < levelMaterials.size();
+		for (unsigned id : levelMeshMaterials)
+			valid = valid && id < levelMaterials.size();
+		valid = valid && (levelMeshGeometry.empty() || levelMeshGeometry.size() == levelMeshes.size());
+		for (unsigned model : levelMeshGeometry)
+			valid = valid && model < levelModels.size();
+		valid = valid && CookedRangesFit();
+		if (valid == false) {
+			log.LogCategorized("WARNING", (std::string("Cooked level is corrupt, rebuilding: ") + cookedPath).c_str());
+			UnloadLevel();
+			return false;
+		}
+		log.LogCategorized("MESSAGE", (std::string("Cooked level read: ") + cookedPath).c_str());
 		return true;
 	}
-};
+};
\ No newline at end of file
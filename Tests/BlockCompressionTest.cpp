@@ -0,0 +1,69 @@
+// Round trips Source/Utils/BlockCompression.h over sizes around the block boundaries and
+// data from incompressible to runs, then feeds it truncated, bit flipped and lying streams.
+// usage: BlockCompressionTest    exit code 0 when every check passed
+#include "../Source/Utils/BlockCompression.h"
+#include <cstdio>
+#include <random>
+
+static int failures = 0;
+static void Check(bool passed, const char* what, size_t size) {
+	if (passed == false && ++failures <= 20)
+		std::printf("FAILED %s (%zu)\n", what, size);
+}
+
+int main() {
+	std::mt19937 random(2024);
+	const size_t sizes[] = { 0, 1, 5, 12, 13, 100, 4096, 65535, 65536, 65537, 131072, 300000, 1000000 };
+	const uint32_t blockSizes[] = { BlockCompression::MIN_BLOCK_SIZE, BlockCompression::DEFAULT_BLOCK_SIZE, BlockCompression::MAX_BLOCK_SIZE };
+	size_t streams = 0;
+	for (size_t size : sizes) {
+		for (int kind = 0; kind < 3; ++kind) { // text like, random, one long run
+			std::vector<unsigned char> data(size);
+			for (auto& c : data)
+				c = static_cast<unsigned char>(kind == 0 ? ((random() % 7 == 0) ? random() : 'a' + random() % 3) : kind == 1 ? random() : 7);
+			for (uint32_t blockSize : blockSizes) {
+				std::vector<unsigned char> packed = BlockCompression::Compress(data.data(), data.size(), blockSize);
+				std::vector<unsigned char> out(size);
+				uint64_t rawSize = 0;
+				Check(BlockCompression::RawSize(packed.data(), packed.size(), rawSize) && rawSize == size, "RawSize", size);
+				Check(BlockCompression::Decompress(packed.data(), packed.size(), out.data(), out.size()) && out == data, "round trip", size);
+				for (size_t prefix : { size_t(0), size_t(1), size_t(20), size_t(blockSize) }) {
+					if (prefix > size || prefix > blockSize)
+						continue;
+					std::vector<unsigned char> head(prefix);
+					Check(BlockCompression::DecompressPrefix(packed.data(), packed.size(), head.data(), prefix) &&
+						std::equal(head.begin(), head.end(), data.begin()), "prefix", prefix);
+				}
+				if (size != 0) // a stream cut short can never inflate
+					Check(BlockCompression::Decompress(packed.data(), packed.size() - 1, out.data(), out.size()) == false, "truncated", size);
+				// flipped bits may decode to other bytes but must stay inside the buffers (run under ASan)
+				for (int flip = 0; flip < 50 && packed.size() > sizeof(BlockCompression::STREAM); ++flip) {
+					std::vector<unsigned char> corrupt = packed;
+					corrupt[random() % corrupt.size()] ^= static_cast<unsigned char>(1u << (random() % 8));
+					BlockCompression::Decompress(corrupt.data(), corrupt.size(), out.data(), out.size());
+					BlockCompression::DecompressPrefix(corrupt.data(), corrupt.size(), out.data(), std::min<size_t>(size, 20));
+				}
+				++streams;
+			}
+		}
+	}
+	// headers that lie about their blocks, every entry point has to refuse them before reading on
+	const std::vector<unsigned char> good = BlockCompression::Compress("header check", 12);
+	for (int lie = 0; lie < 4; ++lie) {
+		std::vector<unsigned char> bad = good;
+		BlockCompression::STREAM stream;
+		std::memcpy(&stream, bad.data(), sizeof(stream));
+		if (lie == 0) stream.blockCount = UINT64_MAX / 2; // the table size wraps
+		if (lie == 1) stream.blockSize = 0xFFFFFFF0u; // a 4 GB block
+		if (lie == 2) stream.rawSize = 1ull << 40; // more blocks than the table holds
+		if (lie == 3) stream.blockCount = 2; // not what rawSize needs
+		std::memcpy(bad.data(), &stream, sizeof(stream));
+		unsigned char out[12];
+		uint64_t rawSize = 0;
+		Check(BlockCompression::RawSize(bad.data(), bad.size(), rawSize) == false, "RawSize bad header", lie);
+		Check(BlockCompression::DecompressPrefix(bad.data(), bad.size(), out, 4) == false, "prefix bad header", lie);
+		Check(BlockCompression::Decompress(bad.data(), bad.size(), out, sizeof(out)) == false, "bad header", lie);
+	}
+	std::printf("%zu streams, %d failures\n", streams, failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Rewrites every .h2b of a folder as v2 (H2B::Builder) and checks it reads back field for
+// field like the v1 original, every mesh and LOD through ReadMesh, and that v2 files with
+// an index past their vertices are rejected.
+// usage: H2BFormatTest <assets folder>    exit code 0 when every check passed
+#include "../Source/Utils/h2bParser.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+static int failures = 0;
+static void Check(bool passed, const char* what, const std::string& file) {
+	if (passed == false && ++failures <= 20)
+		std::printf("FAILED %s (%s)\n", what, file.c_str());
+}
+static bool Same(const char* a, const char* b) {
+	return (a == nullptr || b == nullptr) ? a == b : std::strcmp(a, b) == 0;
+}
+// a copy of a file's bytes with one unsigned overwritten
+static std::vector<unsigned char> Poke(std::vector<unsigned char> bytes, size_t offset, unsigned value) {
+	std::memcpy(bytes.data() + offset, &value, 4);
+	return bytes;
+}
+static void Save(const std::string& path, const std::vector<unsigned char>& bytes) {
+	std::ofstream(path, std::ios_base::binary).write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::printf("usage: %s <assets folder>\n", argv[0]);
+		return 1;
+	}
+	const std::string v2Path = (std::filesystem::temp_directory_path() / "H2BFormatTest.h2b").string();
+	size_t models = 0, levels = 0;
+	for (auto& entry : std::filesystem::directory_iterator(argv[1])) {
+		if (entry.path().extension() != ".h2b")
+			continue;
+		const std::string name = entry.path().filename().string();
+		H2B::View v1, v2;
+		if (v1.Open(entry.path().string().c_str()) == false)
+			continue; // not a valid model to begin with
+		H2B::Builder builder;
+		builder.SetModel(v1);
+		for (unsigned m = 0; m < v1.meshCount; ++m) { // a stand in LOD: the first half of the triangles
+			const H2B::BATCH& draw = v1.meshes[m].drawInfo;
+			builder.AddLod(m, std::vector<unsigned>(v1.indices + draw.indexOffset,
+				v1.indices + draw.indexOffset + draw.indexCount / 6 * 3), 0.5f);
+		}
+		Check(builder.Write(v2Path.c_str()), "write", name);
+		Check(v2.Open(v2Path.c_str()) && v2.Sectioned(), "open v2", name);
+		Check(v2.vertexCount == v1.vertexCount && v2.indexCount == v1.indexCount &&
+			v2.materialCount == v1.materialCount && v2.meshCount == v1.meshCount, "counts", name);
+		if (failures != 0)
+			break;
+		Check(reinterpret_cast<uintptr_t>(v2.vertices) % H2B::SECTION_ALIGNMENT == 0 &&
+			reinterpret_cast<uintptr_t>(v2.indices) % H2B::SECTION_ALIGNMENT == 0, "alignment", name);
+		Check(std::memcmp(v1.vertices, v2.vertices, sizeof(H2B::VERTEX) * v1.vertexCount) == 0 &&
+			std::memcmp(v1.indices, v2.indices, 4ull * v1.indexCount) == 0 &&
+			std::memcmp(v1.batches, v2.batches, sizeof(H2B::BATCH) * v1.materialCount) == 0, "geometry", name);
+		for (unsigned i = 0; i < v1.materialCount; ++i) {
+			Check(std::memcmp(&v1.materials[i].attrib, &v2.materials[i].attrib, sizeof(H2B::ATTRIBUTES)) == 0, "attributes", name);
+			for (int j = 0; j < 10; ++j)
+				Check(Same(*((&v1.materials[i].name) + j), *((&v2.materials[i].name) + j)), "material strings", name);
+		}
+		for (unsigned m = 0; m < v1.meshCount; ++m) {
+			const H2B::MESH& a = v1.meshes[m];
+			const H2B::MESH& b = v2.meshes[m];
+			Check(Same(a.name, b.name) && a.materialIndex == b.materialIndex && a.drawInfo.indexCount == b.drawInfo.indexCount &&
+				a.drawInfo.indexOffset == b.drawInfo.indexOffset, "mesh", name);
+			for (unsigned l = 0; l < v2.LevelCount(m); ++l, ++levels) {
+				H2B::View::MESH_RANGE range;
+				H2B::MESH_DATA mesh;
+				Check(v2.MeshRange(m, l, range) && H2B::ReadMesh(v2Path.c_str(), m, l, mesh), "read mesh", name);
+				for (size_t k = 0; k < mesh.indices.size() && k < range.indexCount; ++k)
+					Check(std::memcmp(&mesh.vertices[mesh.indices[k]], &v1.vertices[range.indices[k]], sizeof(H2B::VERTEX)) == 0, "mesh vertices", name);
+			}
+		}
+		// an index past the vertices, in the model and in a LOD, has to be rejected
+		std::ifstream in(v2Path, std::ios_base::binary);
+		std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		in.close();
+		std::vector<unsigned char> copy = bytes;
+		const unsigned char* base = copy.data();
+		H2B::View memory;
+		Check(memory.Adopt(std::move(copy)), "adopt", name);
+		const size_t indexOffset = reinterpret_cast<const unsigned char*>(memory.indices) - base;
+		const size_t lodOffset = reinterpret_cast<const unsigned char*>(memory.lodIndices) - base;
+		const unsigned lodIndexCount = memory.lodIndexCount;
+		v2.Close();
+		memory.Close();
+		Check(memory.Adopt(Poke(bytes, indexOffset, v1.vertexCount)) == false, "adopt bad index", name);
+		Save(v2Path, Poke(bytes, indexOffset, v1.vertexCount));
+		Check(v2.Open(v2Path.c_str()) == false, "open bad index", name);
+		if (lodIndexCount != 0) { // the first LOD index is mesh 0's first LOD
+			Check(memory.Adopt(Poke(bytes, lodOffset, v1.vertexCount)) == false, "adopt bad LOD index", name);
+			Save(v2Path, Poke(bytes, lodOffset, v1.vertexCount));
+			H2B::MESH_DATA mesh;
+			Check(v2.Open(v2Path.c_str()) == false && H2B::ReadMesh(v2Path.c_str(), 0, 1, mesh) == false, "open bad LOD index", name);
+		}
+		++models;
+	}
+	std::filesystem::remove(v2Path);
+	std::printf("%zu models, %zu mesh levels, %d failures\n", models, levels, failures);
+	return (failures == 0 && models != 0) ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+// Packs the vertices of every .h2b of a folder with Source/Utils/VertexPacking.h and checks
+// the unpacked error stays within what each encoding promises: half a 16 bit step of the
+// bounds for positions, half float rounding for uvs and a few hundredths of a degree for
+// octahedral normals. Then sweeps FloatToHalf and OctEncode with synthetic values.
+// usage: VertexPackingTest <assets folder>    exit code 0 when every check passed
+#include "../Source/Utils/VertexPacking.h"
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+static constexpr float POSITION_LIMIT = 0.5f / 65535.0f + 1e-6f; // of the largest extent
+static constexpr float HALF_ULP = 1.0f / 2048.0f; // relative, 11 bit significand
+static constexpr float NORMAL_LIMIT = 0.05f; // degrees, float acos alone can not resolve less than ~0.03
+
+static int failures = 0;
+static void Check(bool passed, const char* what, const std::string& detail) {
+	if (passed == false && ++failures <= 20)
+		std::printf("FAILED %s (%s)\n", what, detail.c_str());
+}
+static float Degrees(const H2B::VECTOR& a, const H2B::VECTOR& b) {
+	float len = std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+	float cosAngle = (a.x * b.x + a.y * b.y + a.z * b.z) / len;
+	return std::acos(std::min(1.0f, std::max(-1.0f, cosAngle))) * 57.2957795f;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::printf("usage: %s <assets folder>\n", argv[0]);
+		return 1;
+	}
+	size_t models = 0, vertices = 0;
+	VertexPacking::ROUND_TRIP_ERROR all = {};
+	for (auto& entry : std::filesystem::directory_iterator(argv[1])) {
+		H2B::View view;
+		if (entry.path().extension() != ".h2b" || view.Open(entry.path().string().c_str()) == false || view.vertexCount == 0)
+			continue;
+		const std::string name = entry.path().filename().string();
+		// same bounds ComputeLevelBounds gives the model
+		H2B::VECTOR low = view.vertices[0].pos, high = low;
+		float uvRange = 0.0f;
+		for (unsigned i = 0; i < view.vertexCount; ++i) {
+			const H2B::VERTEX& v = view.vertices[i];
+			low = { std::min(low.x, v.pos.x), std::min(low.y, v.pos.y), std::min(low.z, v.pos.z) };
+			high = { std::max(high.x, v.pos.x), std::max(high.y, v.pos.y), std::max(high.z, v.pos.z) };
+			uvRange = std::max(uvRange, std::max(std::fabs(v.uvw.x), std::fabs(v.uvw.y)));
+		}
+		const VertexPacking::BOUNDS bounds = { low, { high.x - low.x, high.y - low.y, high.z - low.z } };
+		std::vector<VertexPacking::PACKED_VERTEX> packed(view.vertexCount);
+		for (unsigned i = 0; i < view.vertexCount; ++i)
+			packed[i] = VertexPacking::Pack(view.vertices[i], bounds);
+		VertexPacking::ROUND_TRIP_ERROR worst = {};
+		VertexPacking::MeasureRoundTrip(view.vertices, packed.data(), view.vertexCount, bounds, worst);
+		Check(worst.positionRelative <= POSITION_LIMIT, "position", name + " " + std::to_string(worst.positionRelative));
+		Check(worst.uv <= uvRange * HALF_ULP + 1e-7f, "uv", name + " " + std::to_string(worst.uv));
+		Check(worst.normalDegrees <= NORMAL_LIMIT, "normal", name + " " + std::to_string(worst.normalDegrees));
+		all = { std::max(all.position, worst.position), std::max(all.positionRelative, worst.positionRelative),
+			std::max(all.uv, worst.uv), std::max(all.normalDegrees, worst.normalDegrees) };
+		++models;
+		vertices += view.vertexCount;
+	}
+	// every half survives a trip through float, signed zero, denormals and infinity included
+	for (uint32_t h = 0; h <= 0xFFFFu; ++h) {
+		const bool nan = (h & 0x7C00u) == 0x7C00u && (h & 0x3FFu) != 0;
+		if (nan == false)
+			Check(VertexPacking::FloatToHalf(VertexPacking::HalfToFloat(static_cast<uint16_t>(h))) == h, "half bits", std::to_string(h));
+	}
+	std::mt19937 random(2024);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	for (int i = 0; i < 100000; ++i) {
+		const float value = unit(random) * std::pow(2.0f, static_cast<float>(static_cast<int>(random() % 40) - 24));
+		const float back = VertexPacking::HalfToFloat(VertexPacking::FloatToHalf(value));
+		Check(std::fabs(back - value) <= std::fabs(value) * HALF_ULP + 3e-8f, "half rounding", std::to_string(value));
+	}
+	// the axes and octahedron folds are where the encoding has its edge cases
+	std::vector<H2B::VECTOR> normals = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+		{ 1, 1, 0 }, { -1, 0, -1 }, { 0.5f, -0.5f, -1e-7f }, { 3, -4, 12 } };
+	for (int i = 0; i < 100000; ++i)
+		normals.push_back({ unit(random), unit(random), unit(random) });
+	for (const H2B::VECTOR& n : normals) {
+		if (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z) <= 0.0f)
+			continue;
+		int16_t encoded[2];
+		VertexPacking::OctEncode(n, encoded);
+		Check(Degrees(n, VertexPacking::OctDecode(encoded)) <= NORMAL_LIMIT, "octahedral",
+			std::to_string(n.x) + " " + std::to_string(n.y) + " " + std::to_string(n.z));
+	}
+	// a flat model has no extent on some axis, its positions come back as the bounds' min
+	const VertexPacking::BOUNDS flat = { { 1.0f, 2.0f, 3.0f }, { 4.0f, 0.0f, 0.0f } };
+	H2B::VERTEX v = {};
+	v.pos = { 3.0f, 2.0f, 3.0f };
+	v.nrm = { 0.0f, 1.0f, 0.0f };
+	const H2B::VERTEX back = VertexPacking::Unpack(VertexPacking::Pack(v, flat), flat);
+	Check(std::fabs(back.pos.x - 3.0f) <= 4.0f * POSITION_LIMIT && back.pos.y == 2.0f && back.pos.z == 3.0f, "flat bounds", "");
+	std::printf("%zu models, %zu vertices: position %g (%g of extent), uv %g, normal %g degrees, %d failures\n",
+		models, vertices, all.position, all.positionRelative, all.uv, all.normalDegrees, failures);
+	return (failures == 0 && models != 0) ? 0 : 1;
+}
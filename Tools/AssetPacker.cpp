@@ -0,0 +1,98 @@
+// Packs the game's loose files into one .pak (see Source/Utils/AssetPack.h) that the
+// renderer mounts at start up instead of opening each file on its own.
+// Run it from the project root so names match the paths the game asks for:
+// usage: AssetPacker [-all] [-store] <out.pak> [folder ...]    e.g. AssetPacker Assets.pak
+//        folders default to Assets Levels Shaders Textures XML, -all also packs
+//        files the game can't read through the pack (.png, .wav ...), -store keeps
+//        textures & geometry uncompressed
+#include "../Source/Utils/AssetPack.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+// what goes through VirtualFile in the game, audio is still opened by path
+static bool Readable(const std::string& extension) {
+	const char* readable[] = { ".h2b", ".txt", ".blvl", ".hlsl", ".dds", ".xml" };
+	std::string lower = AssetPack::NormalizePath(extension);
+	for (const char* r : readable)
+		if (lower == r)
+			return true;
+	return false;
+}
+// the big payloads, text is small and read once
+static bool Compressible(const std::string& extension) {
+	std::string lower = AssetPack::NormalizePath(extension);
+	return lower == ".dds" || lower == ".h2b" || lower == ".blvl";
+}
+
+int main(int argc, char** argv) {
+	bool all = false, store = false;
+	std::string out;
+	std::vector<std::string> folders;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "-all")
+			all = true;
+		else if (arg == "-store")
+			store = true;
+		else if (out.empty())
+			out = arg;
+		else
+			folders.push_back(arg);
+	}
+	if (out.empty()) {
+		std::printf("usage: %s [-all] [-store] <out%s> [folder ...]\n", argv[0], AssetPack::EXTENSION);
+		return 1;
+	}
+	if (folders.empty())
+		folders = { "Assets", "Levels", "Shaders", "Textures", "XML" };
+	auto start = std::chrono::steady_clock::now();
+	AssetPack::Builder builder;
+	std::vector<std::string> files;
+	for (auto& folder : folders) {
+		std::error_code error;
+		for (auto& entry : std::filesystem::recursive_directory_iterator(folder, error))
+			if (entry.is_regular_file() && (all || Readable(entry.path().extension().string())))
+				files.push_back(entry.path().generic_string());
+		if (error)
+			std::fprintf(stderr, "Could not read folder %s\n", folder.c_str());
+	}
+	std::sort(files.begin(), files.end()); // same input, same pack
+	for (auto& file : files)
+		if (builder.Add(file, file, store == false && Compressible(std::filesystem::path(file).extension().string())) == false)
+			std::printf("  warning: %s skipped, a file with the same name (ignoring case) is packed\n", file.c_str());
+	uint64_t bytes = 0, rawBytes = 0;
+	if (builder.Write(out.c_str(), &bytes, &rawBytes) == false) {
+		std::fprintf(stderr, "Could not write %s\n", out.c_str());
+		return 1;
+	}
+	std::printf("%zu files, %llu KB (%llu KB unpacked) -> %s in %.1f ms\n", builder.FileCount(),
+		static_cast<unsigned long long>(bytes / 1024), static_cast<unsigned long long>(rawBytes / 1024), out.c_str(),
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	// read back what the game will inflate, checks the pack & measures the decoder
+	AssetPack::View view;
+	if (view.Open(out.c_str()) == false) {
+		std::fprintf(stderr, "Could not read back %s\n", out.c_str());
+		return 1;
+	}
+	std::vector<std::vector<unsigned char>> inflated;
+	std::vector<BlockCompression::JOB> jobs;
+	for (size_t i = 0; i < view.FileCount(); ++i) {
+		const AssetPack::ENTRY* e = view.Find(view.Name(i));
+		if (e == nullptr || AssetPack::View::Compressed(*e) == false)
+			continue;
+		inflated.emplace_back(static_cast<size_t>(e->size));
+		jobs.push_back({ view.Data(*e), static_cast<size_t>(e->stored), inflated.back().data(), inflated.back().size() });
+	}
+	if (jobs.empty() == false) {
+		BlockCompression::STATS stats;
+		if (BlockCompression::Decompress(jobs, &stats) == false) {
+			std::fprintf(stderr, "%s does not inflate back\n", out.c_str());
+			return 1;
+		}
+		std::printf("%zu compressed files, %llu KB -> %llu KB, inflate %.0f MB/s on %u threads, %.0f MB/s per core\n",
+			jobs.size(), static_cast<unsigned long long>(stats.rawBytes / 1024),
+			static_cast<unsigned long long>(stats.packedBytes / 1024), stats.MBps(), stats.threads, stats.MBpsPerCore());
+	}
+	return 0;
+}
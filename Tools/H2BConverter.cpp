@@ -0,0 +1,72 @@
+// Rewrites .h2b models in the sectioned v2 layout (see H2B::HEADER_V2 in Source/Utils/h2bParser.h),
+// optionally with simplified LODs stored per mesh. Level_Data and the renderer read v1 and v2 alike.
+// usage: H2BConverter [-lods <levels>] <model.h2b> [more.h2b ...]    rewrites each file in place
+//        H2BConverter [-lods <levels>] <model.h2b> -o <out.h2b>
+#include "../Source/Utils/h2bParser.h"
+#include "../Source/Utils/MeshOptimizer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+static bool Convert(const char* input, const std::string& output, unsigned levels) {
+	auto start = std::chrono::steady_clock::now();
+	H2B::Builder builder;
+	size_t inputBytes = 0, lodCount = 0;
+	{
+		H2B::View view;
+		if (view.Open(input) == false) {
+			std::fprintf(stderr, "Could not read %s\n", input);
+			return false;
+		}
+		inputBytes = view.FileSize();
+		builder.SetModel(view);
+		// same simplification Level_Data::GenerateLevelLods runs at load time, each level halves the triangles
+		std::vector<int> scratch(view.vertexCount, -1);
+		for (unsigned j = 0; j < view.meshCount; ++j) {
+			const H2B::BATCH& draw = view.meshes[j].drawInfo;
+			size_t previous = draw.indexCount;
+			float error = 0.0f;
+			for (unsigned l = 1; l < levels; ++l) {
+				size_t target = (static_cast<size_t>(draw.indexCount) >> l) / 3 * 3;
+				float levelError = 0.0f;
+				std::vector<unsigned> simple = MeshOptimizer::SimplifyMesh(view.vertices, view.vertexCount,
+					view.indices + draw.indexOffset, draw.indexCount, target, levelError);
+				if (simple.size() >= previous)
+					break; // stuck, coarser levels would be the same
+				MeshOptimizer::OptimizeVertexCacheRange(simple.data(), simple.size(), scratch);
+				error = std::max(error, levelError);
+				builder.AddLod(j, simple, error);
+				previous = simple.size();
+				++lodCount;
+			}
+		}
+	} // unmapped before the output (possibly the same file) is written
+	unsigned long long outputBytes = 0;
+	if (builder.Write(output.c_str(), &outputBytes) == false) {
+		std::fprintf(stderr, "Could not write %s\n", output.c_str());
+		return false;
+	}
+	std::printf("%s -> %s: %zu LODs, %zu -> %llu bytes in %.1f ms\n", input, output.c_str(), lodCount,
+		inputBytes, outputBytes, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	return true;
+}
+
+int main(int argc, char** argv) {
+	unsigned levels = 1; // the original only
+	int first = 1;
+	if (argc > 2 && std::string(argv[1]) == "-lods") {
+		levels = static_cast<unsigned>(std::max(1, std::atoi(argv[2])));
+		first = 3;
+	}
+	if (argc <= first) {
+		std::printf("usage: %s [-lods <levels>] <model.h2b> [more.h2b ...]\n       %s [-lods <levels>] <model.h2b> -o <out.h2b>\n",
+			argv[0], argv[0]);
+		return 1;
+	}
+	if (argc == first + 3 && std::string(argv[first + 1]) == "-o")
+		return Convert(argv[first], argv[first + 2], levels) ? 0 : 1;
+	int failed = 0;
+	for (int i = first; i < argc; ++i)
+		failed += Convert(argv[i], argv[i], levels) ? 0 : 1;
+	return failed == 0 ? 0 : 1;
+}
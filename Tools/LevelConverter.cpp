@@ -0,0 +1,56 @@
+// Converts GameLevel.txt files written by LevelExporter.py into the binary .blvl
+// layout (see Source/Utils/LevelLayout.h) that Level_Data::LoadLevel reads without parsing.
+// usage: LevelConverter <level.txt> [more.txt ...]    writes level.blvl next to each input
+//        LevelConverter <level.txt> -o <out.blvl>
+#include "../Source/Utils/LevelLayout.h"
+#include <chrono>
+#include <cstdio>
+
+static std::string OutputPath(const std::string& input) {
+	size_t dot = input.find_last_of('.');
+	size_t slash = input.find_last_of("/\\");
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+		return input.substr(0, dot) + LevelLayout::EXTENSION;
+	return input + LevelLayout::EXTENSION;
+}
+
+static bool Convert(const char* input, const std::string& output) {
+	auto start = std::chrono::steady_clock::now();
+	MappedFile text;
+	if (text.Open(input) == false) {
+		std::fprintf(stderr, "Could not open %s\n", input);
+		return false;
+	}
+	LevelLayout::Builder builder;
+	size_t malformed = builder.AddText(reinterpret_cast<const char*>(text.Data()), text.Size());
+	if (builder.Write(output.c_str()) == false) {
+		std::fprintf(stderr, "Could not write %s\n", output.c_str());
+		return false;
+	}
+	unsigned long long size = 0;
+	long long modified = 0;
+	MappedFile::Stat(output.c_str(), size, modified);
+	std::printf("%s -> %s: %zu meshes of %zu models, %zu -> %llu bytes in %.1f ms\n", input, output.c_str(),
+		builder.RecordCount(), builder.ModelCount(), text.Size(), size,
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	if (malformed > 0)
+		std::printf("  warning: %zu malformed MESH block(s) skipped\n", malformed);
+	if (builder.ProjectiveCount() > 0)
+		std::printf("  warning: %zu matrices had a last column other than 0,0,0,1 and were made affine\n",
+			builder.ProjectiveCount());
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::printf("usage: %s <level.txt> [more.txt ...]\n       %s <level.txt> -o <out%s>\n",
+			argv[0], argv[0], LevelLayout::EXTENSION);
+		return 1;
+	}
+	if (argc == 4 && std::string(argv[2]) == "-o")
+		return Convert(argv[1], argv[3]) ? 0 : 1;
+	int failed = 0;
+	for (int i = 1; i < argc; ++i)
+		failed += Convert(argv[i], OutputPath(argv[i])) ? 0 : 1;
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+// Generates large, reproducible stress levels by scattering the real Assets/*.h2b models.
+// Writes the exporter's text format (<out>.txt) and the binary layout (<out>.blvl),
+// both load through Level_Data::LoadLevel. The same options and seed always give the
+// same level on every platform (own random generator, no <random> distributions).
+// usage: LevelGenerator [options] <out>     e.g. LevelGenerator -n 100000 -layout clusters Levels/Stress100k
+#include "../Source/Utils/LevelLayout.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+struct GENERATOR_SETTINGS
+{
+	size_t count = 10000; // instances, 1k to 1M is the interesting range
+	size_t models = 0; // unique models to use, 0 = every .h2b in the assets folder
+	float mixSkew = 0.0f; // 0 = every model equally likely, 1+ = zipf like, a few models dominate
+	std::string layout = "uniform"; // uniform, grid or clusters
+	float extent = 0.0f; // half size of the square level, 0 = grows with count (about 4 units per instance)
+	size_t clusters = 16; // cluster centers for the clusters layout
+	float clusterSpread = 0.05f; // standard deviation of a cluster, as a fraction of the extent
+	float clustered = 0.9f; // fraction of instances placed in clusters, the rest is uniform
+	float minScale = 1.0f, maxScale = 1.0f; // uniform scale range per instance
+	float heightJitter = 0.0f; // random Y offset range
+	unsigned long long seed = 1;
+	std::string assets = "Assets";
+	std::string out;
+};
+
+// splitmix64, tiny and identical everywhere
+struct RANDOM
+{
+	unsigned long long state;
+	unsigned long long Next() {
+		unsigned long long z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+	double Unit() { return (Next() >> 11) * (1.0 / 9007199254740992.0); } // [0, 1)
+	float Range(float lo, float hi) { return lo + static_cast<float>(Unit()) * (hi - lo); }
+	size_t Index(size_t n) { return static_cast<size_t>(Unit() * n); }
+	float Normal() { // Box-Muller
+		double u = 1.0 - Unit();
+		return static_cast<float>(std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * Unit()));
+	}
+};
+
+static void Usage(const char* exe) {
+	std::printf("usage: %s [options] <out>   writes <out>.txt and <out>%s\n"
+		"  -n <count>          instances (default 10000)\n"
+		"  -models <k>         unique models used, 0 = all in the assets folder (default 0)\n"
+		"  -skew <s>           model mix, 0 = even, 1 = zipf (default 0)\n"
+		"  -layout <name>      uniform | grid | clusters (default uniform)\n"
+		"  -extent <e>         half size of the level, 0 = from count (default 0)\n"
+		"  -clusters <c>       cluster count (default 16)\n"
+		"  -spread <f>         cluster std deviation as a fraction of extent (default 0.05)\n"
+		"  -clustered <f>      fraction of instances in clusters (default 0.9)\n"
+		"  -scale <min> <max>  uniform scale range (default 1 1)\n"
+		"  -height <h>         random Y offset range (default 0)\n"
+		"  -seed <s>           (default 1)\n"
+		"  -assets <dir>       folder with the .h2b models (default Assets)\n", exe, LevelLayout::EXTENSION);
+}
+
+static bool ParseArguments(int argc, char** argv, GENERATOR_SETTINGS& s) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : "0"; };
+		if (arg == "-n") s.count = std::strtoull(value(), nullptr, 10);
+		else if (arg == "-models") s.models = std::strtoull(value(), nullptr, 10);
+		else if (arg == "-skew") s.mixSkew = std::strtof(value(), nullptr);
+		else if (arg == "-layout") s.layout = value();
+		else if (arg == "-extent") s.extent = std::strtof(value(), nullptr);
+		else if (arg == "-clusters") s.clusters = std::strtoull(value(), nullptr, 10);
+		else if (arg == "-spread") s.clusterSpread = std::strtof(value(), nullptr);
+		else if (arg == "-clustered") s.clustered = std::strtof(value(), nullptr);
+		else if (arg == "-scale") { s.minScale = std::strtof(value(), nullptr); s.maxScale = std::strtof(value(), nullptr); }
+		else if (arg == "-height") s.heightJitter = std::strtof(value(), nullptr);
+		else if (arg == "-seed") s.seed = std::strtoull(value(), nullptr, 10);
+		else if (arg == "-assets") s.assets = value();
+		else if (arg[0] == '-') { std::fprintf(stderr, "unknown option %s\n", arg.c_str()); return false; }
+		else s.out = arg;
+	}
+	if (s.layout != "uniform" && s.layout != "grid" && s.layout != "clusters") {
+		std::fprintf(stderr, "unknown layout %s\n", s.layout.c_str());
+		return false;
+	}
+	return s.out.empty() == false && s.count > 0;
+}
+
+// the exporter writes blender's Matrix.__str__, 4 decimals per element padded to 7
+static void AppendMatrix(std::string& text, const float (&m)[16]) {
+	for (int r = 0; r < 4; ++r) {
+		text += (r == 0) ? "<Matrix 4x4 (" : "            (";
+		for (int c = 0; c < 4; ++c) {
+			char number[32];
+			char* end = std::to_chars(number, number + sizeof(number), m[r * 4 + c],
+				std::chars_format::fixed, 4).ptr;
+			if (end - number < 7)
+				text.append(7 - (end - number), ' ');
+			text.append(number, end);
+			text += (c < 3) ? ", " : ")";
+		}
+		text += (r == 3) ? ">\n" : "\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	GENERATOR_SETTINGS s;
+	if (ParseArguments(argc, argv, s) == false) {
+		Usage(argv[0]);
+		return 1;
+	}
+	auto start = std::chrono::steady_clock::now();
+	// every model the level can use, sorted so the pick doesn't depend on directory order
+	std::vector<std::string> models;
+	std::error_code error;
+	for (auto& file : std::filesystem::directory_iterator(s.assets, error))
+		if (file.path().extension() == ".h2b")
+			models.push_back(file.path().stem().string());
+	if (models.empty()) {
+		std::fprintf(stderr, "no .h2b models found in %s\n", s.assets.c_str());
+		return 1;
+	}
+	std::sort(models.begin(), models.end());
+	RANDOM random = { s.seed };
+	for (size_t i = models.size(); i > 1; --i) // seeded shuffle, then keep the first k
+		std::swap(models[i - 1], models[random.Index(i)]);
+	if (s.models > 0 && s.models < models.size())
+		models.resize(s.models);
+	// model mix, cumulative weights 1 / (rank + 1)^skew
+	std::vector<double> cumulative(models.size());
+	double total = 0.0;
+	for (size_t i = 0; i < models.size(); ++i)
+		cumulative[i] = (total += 1.0 / std::pow(static_cast<double>(i + 1), s.mixSkew));
+	const float extent = (s.extent > 0.0f) ? s.extent : std::sqrt(static_cast<float>(s.count)) * 2.0f;
+	std::vector<float> centers(s.clusters * 2);
+	for (auto& c : centers)
+		c = random.Range(-extent, extent);
+	const size_t gridSide = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(s.count))));
+
+	std::vector<size_t> perModel(models.size(), 0);
+	std::string text = "# Game Level Exporter v1.0\nCAMERA\nCamera\n";
+	const float camera[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, extent * 0.25f, -extent, 1 };
+	AppendMatrix(text, camera);
+	text.reserve(text.size() + s.count * 220);
+	for (size_t i = 0; i < s.count; ++i) {
+		size_t model = std::upper_bound(cumulative.begin(), cumulative.end(), random.Unit() * total) - cumulative.begin();
+		model = std::min(model, models.size() - 1);
+		float x, z;
+		if (s.layout == "grid") {
+			float step = 2.0f * extent / gridSide;
+			x = -extent + (i % gridSide + 0.5f) * step;
+			z = -extent + (i / gridSide + 0.5f) * step;
+		}
+		else if (s.layout == "clusters" && s.clusters > 0 && random.Unit() < s.clustered) {
+			size_t c = random.Index(s.clusters);
+			x = centers[c * 2 + 0] + random.Normal() * s.clusterSpread * extent;
+			z = centers[c * 2 + 1] + random.Normal() * s.clusterSpread * extent;
+		}
+		else {
+			x = random.Range(-extent, extent);
+			z = random.Range(-extent, extent);
+		}
+		float y = random.Range(0.0f, s.heightJitter);
+		float yaw = random.Range(0.0f, 6.2831853f);
+		float scale = random.Range(s.minScale, s.maxScale);
+		float c = std::cos(yaw) * scale, sn = std::sin(yaw) * scale;
+		const float m[16] = { c, 0, -sn, 0,  0, scale, 0, 0,  sn, 0, c, 0,  x, y, z, 1 };
+		// blender style names: Arch, Arch.001, Arch.002 ...
+		char suffix[24] = "";
+		if (perModel[model] > 0)
+			std::snprintf(suffix, sizeof(suffix), ".%03zu", perModel[model]);
+		++perModel[model];
+		text.append("MESH\n").append(models[model]).append(suffix).append("\n");
+		AppendMatrix(text, m);
+	}
+	const std::string textPath = s.out + ".txt";
+	const std::string binaryPath = s.out + LevelLayout::EXTENSION;
+	{
+		std::ofstream file(textPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (file.is_open() == false || file.write(text.data(), text.size()).good() == false) {
+			std::fprintf(stderr, "Could not write %s\n", textPath.c_str());
+			return 1;
+		}
+	}
+	// built from the text so both files hold exactly the same (rounded) values
+	LevelLayout::Builder builder;
+	builder.AddText(text.data(), text.size());
+	if (builder.Write(binaryPath.c_str()) == false) {
+		std::fprintf(stderr, "Could not write %s\n", binaryPath.c_str());
+		return 1;
+	}
+	std::printf("%zu instances of %zu models, layout %s, extent %.1f, seed %llu -> %s + %s in %.1f ms\n",
+		s.count, models.size(), s.layout.c_str(), extent, s.seed, textPath.c_str(), binaryPath.c_str(),
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	for (size_t i = 0; i < models.size(); ++i)
+		std::printf("  %-24s %zu\n", models[i].c_str(), perModel[i]);
+	return 0;
+}